@@ -21,5 +21,11 @@ public class KilographUnrealAppTarget : TargetRules
 		)
 	{
 		OutExtraModuleNames.Add("KilographUnrealApp");
+
+		// The automation tests ship with every build but the one that goes out
+		if (Target.Configuration != UnrealTargetConfiguration.Shipping)
+		{
+			OutExtraModuleNames.Add("KilographUnrealAppTests");
+		}
 	}
 }
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "BoundsHierarchy.h"
+
+// Most items kept in a single leaf of the hierarchy
+static const int32 MaxItemsPerLeaf = 4;
+
+// Deepest traversal the hierarchy can need, median splits keep it far below this
+static const int32 MaxTraversalDepth = 64;
+
+void FBoundsHierarchy::build(const TArray<FBox> &bounds)
+{
+	nodes.Reset();
+	items.Reset();
+	itemBounds.Reset();
+
+	for (int32 boundsIndex = 0; boundsIndex < bounds.Num(); boundsIndex++)
+	{
+		if (bounds[boundsIndex].IsValid)
+		{
+			items.Add(boundsIndex);
+			itemBounds.Add(bounds[boundsIndex]);
+		}
+	}
+
+	if (items.Num() == 0)
+	{
+		return;
+	}
+
+	nodes.Reserve(2 * (items.Num() / MaxItemsPerLeaf + 1));
+	nodes.AddUninitialized(1);
+	buildNode(0, 0, items.Num());
+}
+
+int32 FBoundsHierarchy::raycast(const FVector &origin, const FVector &direction, float maxDistance, float &outDistance) const
+{
+	if (nodes.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const FVector inverseDirection(
+		direction.X != 0.0f ? 1.0f / direction.X : BIG_NUMBER,
+		direction.Y != 0.0f ? 1.0f / direction.Y : BIG_NUMBER,
+		direction.Z != 0.0f ? 1.0f / direction.Z : BIG_NUMBER);
+
+	int32 closestItem = INDEX_NONE;
+	float closestDistance = maxDistance;
+
+	int32 stack[MaxTraversalDepth];
+	int32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const FNode &node = nodes[stack[--stackSize]];
+		if (intersectBox(node.bounds, origin, inverseDirection, closestDistance) < 0.0f)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int32 itemIndex = node.first; itemIndex < node.first + node.count; itemIndex++)
+			{
+				const float distance = intersectBox(itemBounds[itemIndex], origin, inverseDirection, closestDistance);
+				if (distance >= 0.0f && (closestItem == INDEX_NONE || distance < closestDistance))
+				{
+					closestItem = items[itemIndex];
+					closestDistance = distance;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so the farther one can be culled against the closest hit
+		const float leftDistance = intersectBox(nodes[node.first].bounds, origin, inverseDirection, closestDistance);
+		const float rightDistance = intersectBox(nodes[node.first + 1].bounds, origin, inverseDirection, closestDistance);
+		const bool leftFirst = rightDistance < 0.0f || (leftDistance >= 0.0f && leftDistance <= rightDistance);
+		const int32 nearChild = leftFirst ? node.first : node.first + 1;
+		const int32 farChild = leftFirst ? node.first + 1 : node.first;
+
+		if ((leftFirst ? rightDistance : leftDistance) >= 0.0f)
+		{
+			stack[stackSize++] = farChild;
+		}
+		if ((leftFirst ? leftDistance : rightDistance) >= 0.0f)
+		{
+			stack[stackSize++] = nearChild;
+		}
+	}
+
+	outDistance = closestDistance;
+	return closestItem;
+}
+
+void FBoundsHierarchy::buildNode(int32 nodeIndex, int32 first, int32 count)
+{
+	FBox bounds(0);
+	FBox centerBounds(0);
+	for (int32 itemIndex = first; itemIndex < first + count; itemIndex++)
+	{
+		bounds += itemBounds[itemIndex];
+		centerBounds += itemBounds[itemIndex].GetCenter();
+	}
+
+	nodes[nodeIndex].bounds = bounds;
+
+	const FVector centerExtent = centerBounds.GetExtent();
+	if (count <= MaxItemsPerLeaf || centerExtent.IsNearlyZero())
+	{
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].count = count;
+		return;
+	}
+
+	// Split at the median along the axis where the item centers are spread the most
+	const int32 axis = (centerExtent.X >= centerExtent.Y && centerExtent.X >= centerExtent.Z) ? 0 : (centerExtent.Y >= centerExtent.Z ? 1 : 2);
+
+	TArray<int32> order;
+	order.AddUninitialized(count);
+	for (int32 orderIndex = 0; orderIndex < count; orderIndex++)
+	{
+		order[orderIndex] = first + orderIndex;
+	}
+	const TArray<FBox> &boundsToSort = itemBounds;
+	order.Sort([&boundsToSort, axis](int32 a, int32 b) { return boundsToSort[a].GetCenter()[axis] < boundsToSort[b].GetCenter()[axis]; });
+
+	TArray<int32> sortedItems;
+	TArray<FBox> sortedBounds;
+	sortedItems.Reserve(count);
+	sortedBounds.Reserve(count);
+	for (int32 orderIndex = 0; orderIndex < count; orderIndex++)
+	{
+		sortedItems.Add(items[order[orderIndex]]);
+		sortedBounds.Add(itemBounds[order[orderIndex]]);
+	}
+	for (int32 orderIndex = 0; orderIndex < count; orderIndex++)
+	{
+		items[first + orderIndex] = sortedItems[orderIndex];
+		itemBounds[first + orderIndex] = sortedBounds[orderIndex];
+	}
+
+	const int32 leftCount = count / 2;
+	const int32 childIndex = nodes.AddUninitialized(2);
+	nodes[nodeIndex].first = childIndex;
+	nodes[nodeIndex].count = 0;
+
+	buildNode(childIndex, first, leftCount);
+	buildNode(childIndex + 1, first + leftCount, count - leftCount);
+}
+
+float FBoundsHierarchy::intersectBox(const FBox &box, const FVector &origin, const FVector &inverseDirection, float maxDistance)
+{
+	float entryDistance = 0.0f;
+	float exitDistance = maxDistance;
+
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		const float slabMin = (box.Min[axis] - origin[axis]) * inverseDirection[axis];
+		const float slabMax = (box.Max[axis] - origin[axis]) * inverseDirection[axis];
+		entryDistance = FMath::Max(entryDistance, FMath::Min(slabMin, slabMax));
+		exitDistance = FMath::Min(exitDistance, FMath::Max(slabMin, slabMax));
+	}
+
+	return entryDistance <= exitDistance ? entryDistance : -1.0f;
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Bounding volume hierarchy over a set of boxes, built with median splits along the axis where
+ * the box centers are spread the most. Ray queries visit the nearer child first and cull the
+ * farther one against the closest hit, so their cost grows with the log of the box count.
+ */
+struct KILOGRAPHUNREALAPP_API FBoundsHierarchy
+{
+	// Build the hierarchy over the given boxes, invalid boxes are left out
+	void build(const TArray<FBox> &bounds);
+
+	/**
+	* Find the closest box hit by a ray
+	* @param	origin		Start of the ray
+	* @param	direction	Unit direction of the ray
+	* @param	maxDistance	Length of the ray
+	* @param	outDistance	Distance along the ray at which the box is entered
+	* @returns the index of the box hit in the array the hierarchy was built from, INDEX_NONE if there is none
+	*/
+	int32 raycast(const FVector &origin, const FVector &direction, float maxDistance, float &outDistance) const;
+
+	// Distance at which a ray enters a box, negative if it misses within maxDistance
+	static float intersectBox(const FBox &box, const FVector &origin, const FVector &inverseDirection, float maxDistance);
+
+private:
+	struct FNode
+	{
+		FBox bounds;
+		// Leaves reference count items from first, interior nodes have their children at first and first + 1
+		int32 first;
+		int32 count;
+	};
+
+	// Recursively build the node at nodeIndex over a range of items
+	void buildNode(int32 nodeIndex, int32 first, int32 count);
+
+	TArray<FNode> nodes;
+
+	/** Items are indices into the boxes the hierarchy was built from, kept in leaf order with their bounds */
+	TArray<int32> items;
+	TArray<FBox> itemBounds;
+};
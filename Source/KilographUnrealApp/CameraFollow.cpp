@@ -3,15 +3,36 @@
 #include "KilographUnrealApp.h"
 #include "CameraFollow.h"
 #include "KilographUnrealAppCharacter.h"
+#include "TourPrefetcher.h"
+#include "TourAsset.h"
+#include "GameFramework/CharacterMovementComponent.h"
 
+DECLARE_CYCLE_STAT(TEXT("CameraFollow Tick"), STAT_CameraFollowTick, STATGROUP_Kilograph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("CameraFollow Ticks"), STAT_CameraFollowTicks, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Tours"), STAT_ActiveTours, STATGROUP_Kilograph);
 
 // Sets default values for this component's properties
 UCameraFollow::UCameraFollow()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	// Set this component to be initialized when the game starts. It only ticks while a tour is running,
+	// startFollowing and stopFollowing turn the tick on and off.
 	bWantsBeginPlay = true;
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// The tour moves the player, so it has to run before physics and the camera update
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	tourSpeed = 600.0f;
+	orientAlongPath = false;
+	fixedStepRate = 0.0f;
+	maxSubsteps = 4;
+	distanceAlongPath = 0.0f;
+	stepAccumulator = 0.0f;
+	followMode = false;
+	prefetcher = NULL;
+	currentTour = INDEX_NONE;
+	currentControlPoint = 0;
+	dwellRemaining = 0.0f;
 }
 
 // Called when the game starts
@@ -19,20 +40,97 @@ void UCameraFollow::BeginPlay()
 {
 	Super::BeginPlay();
 
+	bakePath();
+
+	prefetcher = GetOwner()->FindComponentByClass<UTourPrefetcher>();
+}
+
+void UCameraFollow::bakePath()
+{
+	// Bake every tour once, switching tours only picks another baked spline. Empty entries are
+	// skipped rather than removed, the designer's list is left as it was set up
+	tourPaths.Reset();
+	tourAssets.Reset();
+	for (int tourIndex = 0; tourIndex < tours.Num(); tourIndex++)
+	{
+		if (tours[tourIndex] != NULL)
+		{
+			FTourPath &path = tourPaths[tourPaths.AddDefaulted()];
+			tours[tourIndex]->buildPath(path);
+			tourAssets.Add(tours[tourIndex]);
+		}
+	}
+
+	if (tourPaths.Num() > 0)
+	{
+		currentTour = 0;
+		return;
+	}
+
+	// Without tour assets the path is built from the path elements under the owner
+	currentTour = INDEX_NONE;
+	gatherPathElements(cameraPathElements);
+
+	// Bake the path once, the tour only samples it by distance from here on
+	TArray<FVector> controlPoints;
+	controlPoints.Reserve(cameraPathElements.Num());
+	for (int elementIndex = 0; elementIndex < cameraPathElements.Num(); elementIndex++)
+	{
+		controlPoints.Add(cameraPathElements[elementIndex]->GetActorLocation());
+	}
+	tourPath.build(controlPoints);
+
+	//UE_LOG(Kilograph, Log, TEXT("Number of path elements: %d, path length: %f"), cameraPathElements.Num(), tourPath.getLength());
+}
+
+void UCameraFollow::gatherPathElements(TArray<AActor *> &outElements) const
+{
+	outElements.Reset();
+
 	TArray<USceneComponent*> childrenRoots;
 	GetOwner()->GetRootComponent()->GetChildrenComponents(true, childrenRoots);
 
 	for (int childIndex = 0; childIndex < childrenRoots.Num(); childIndex++)
 	{
-		cameraPathElements.Add(childrenRoots[childIndex]->GetOwner());
+		// Actors with several components show up more than once, only the first occurrence counts
+		AActor *pathElement = childrenRoots[childIndex]->GetOwner();
+		if (pathElement != GetOwner())
+		{
+			outElements.AddUnique(pathElement);
+		}
+	}
+}
+
+bool UCameraFollow::selectTour(int32 tourIndex)
+{
+	if (!tourPaths.IsValidIndex(tourIndex) || !tourPaths[tourIndex].isValid())
+	{
+		return false;
+	}
+
+	currentTour = tourIndex;
+	if (followMode)
+	{
+		distanceAlongPath = 0.0f;
+		stepAccumulator = 0.0f;
+		currentControlPoint = 0;
+		dwellRemaining = 0.0f;
+		applyPathSample();
 	}
+	return true;
+}
 
-	//UE_LOG(Kilograph, Log, TEXT("Number of path elements: %d"), cameraPathElements.Num());
+FString UCameraFollow::getTourName() const
+{
+	return currentTour != INDEX_NONE ? tourAssets[currentTour]->GetName() : GetOwner()->GetName();
 }
 
 // Called every frame
 void UCameraFollow::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CameraFollowTick);
+	INC_DWORD_STAT(STAT_CameraFollowTicks);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
 	if (!followMode)
@@ -40,27 +138,110 @@ void UCameraFollow::TickComponent(float DeltaTime, ELevelTick TickType, FActorCo
 		return;
 	}
 
-	AActor *nextBox = cameraPathElements[currentIndex];
+	if (fixedStepRate <= 0.0f)
+	{
+		advance(DeltaTime);
+		applyPathSample();
+		return;
+	}
+
+	// Advance in whole fixed steps only so the tour lands on the same points regardless of frame rate,
+	// each step taken on its own so rests and speed changes are crossed the same way every time
+	const float stepTime = 1.0f / fixedStepRate;
+	stepAccumulator += DeltaTime;
+	const int32 steps = FMath::Min(FMath::FloorToInt(stepAccumulator / stepTime), FMath::Max(maxSubsteps, 1));
+	if (steps == 0)
+	{
+		return;
+	}
+	stepAccumulator = FMath::Min(stepAccumulator - steps * stepTime, stepTime);
+
+	for (int32 step = 0; step < steps; step++)
+	{
+		advance(stepTime);
+	}
+	applyPathSample();
+}
+
+float UCameraFollow::getSpeedAtDistance(float distance) const
+{
+	if (currentTour == INDEX_NONE)
+	{
+		return tourSpeed;
+	}
 
-	FVector distanceVector = nextBox->GetActorLocation() - player->GetActorLocation();
+	const TArray<FTourControlPoint> &controlPoints = tourAssets[currentTour]->getControlPoints();
+	float alpha;
+	const int32 pointIndex = getTourPath().findSegment(distance, alpha);
+	const FTourControlPoint &point = controlPoints[pointIndex];
+	const FTourControlPoint &nextPoint = controlPoints[(pointIndex + 1) % controlPoints.Num()];
+	return FMath::Lerp(point.speed > 0.0f ? point.speed : tourSpeed, nextPoint.speed > 0.0f ? nextPoint.speed : tourSpeed, alpha);
+}
 
-	//UE_LOG(Kilograph, Log, TEXT("MAGNITUDE: %f"), distanceVector.Size());
+void UCameraFollow::advance(float stepTime)
+{
+	const FTourPath &path = getTourPath();
+	if (currentTour == INDEX_NONE)
+	{
+		distanceAlongPath = path.wrapDistance(distanceAlongPath + tourSpeed * stepTime);
+		return;
+	}
 
-	if (distanceVector.Size() < 100.0f)
+	// Control points carry their own speed and rest time, the step is split wherever it reaches one
+	const TArray<FTourControlPoint> &controlPoints = tourAssets[currentTour]->getControlPoints();
+	const int32 numPoints = path.getNumControlPoints();
+	while (stepTime > 0.0f)
 	{
-		currentIndex++;
-		if (currentIndex >= cameraPathElements.Num())
+		if (dwellRemaining > 0.0f)
 		{
-			currentIndex = 0;
-			nextBox = cameraPathElements[currentIndex];
-			distanceVector = nextBox->GetActorLocation() - player->GetActorLocation();
+			const float rest = FMath::Min(dwellRemaining, stepTime);
+			dwellRemaining -= rest;
+			stepTime -= rest;
+			continue;
 		}
+
+		const float speed = getSpeedAtDistance(distanceAlongPath);
+		if (speed <= KINDA_SMALL_NUMBER)
+		{
+			return;
+		}
+
+		// Distance left to the next control point, the last segment ends at the loop's length
+		const float segmentEnd = currentControlPoint + 1 < numPoints ? path.getControlPointDistance(currentControlPoint + 1) : path.getLength();
+		const float remaining = segmentEnd - distanceAlongPath;
+		if (speed * stepTime < remaining)
+		{
+			distanceAlongPath += speed * stepTime;
+			return;
+		}
+
+		stepTime -= remaining / speed;
+		currentControlPoint = (currentControlPoint + 1) % numPoints;
+		distanceAlongPath = path.getControlPointDistance(currentControlPoint);
+		dwellRemaining = controlPoints[currentControlPoint].dwell;
+	}
+}
+
+void UCameraFollow::applyPathSample()
+{
+	const FTourPath &path = getTourPath();
+	const FVector location = path.getLocationAtDistance(distanceAlongPath);
+	player->SetActorLocation(location);
+
+	if (player->GetController() == NULL)
+	{
+		return;
 	}
 
-	distanceVector.Normalize();
-	//UE_LOG(Kilograph, Log, TEXT("DISTANCE: %s"), *distanceVector.ToString());
-	//UE_LOG(Kilograph, Log, TEXT("Movement amount: %f"), 1000.0f * DeltaTime);
-	player->AddMovementInput(distanceVector, 1000.0f * DeltaTime);
+	// A look at target on the current segment takes precedence over facing along the path
+	if (currentTour != INDEX_NONE && tourAssets[currentTour]->getControlPoints()[currentControlPoint].hasLookAt)
+	{
+		player->GetController()->SetControlRotation((tourAssets[currentTour]->getControlPoints()[currentControlPoint].lookAt - location).Rotation());
+	}
+	else if (orientAlongPath)
+	{
+		player->GetController()->SetControlRotation(path.getDirectionAtDistance(distanceAlongPath).Rotation());
+	}
 }
 
 void UCameraFollow::setPlayer(AKilographUnrealAppCharacter *playerInput)
@@ -70,14 +251,49 @@ void UCameraFollow::setPlayer(AKilographUnrealAppCharacter *playerInput)
 
 void UCameraFollow::startFollowing()
 {
-	currentIndex = 0;
-	player->SetActorLocation(GetOwner()->GetActorLocation());
+	if (!getTourPath().isValid())
+	{
+		UE_LOG(Kilograph, Warning, TEXT("Camera path %s needs at least two control points"), *getTourName());
+		return;
+	}
+
+	// The path drives the player directly, keep character movement from fighting it or ticking at all
+	player->GetCharacterMovement()->DisableMovement();
+	player->GetCharacterMovement()->SetComponentTickEnabled(false);
+
+	distanceAlongPath = 0.0f;
+	stepAccumulator = 0.0f;
+	currentControlPoint = 0;
+	dwellRemaining = currentTour != INDEX_NONE ? tourAssets[currentTour]->getControlPoints()[0].dwell : 0.0f;
+	applyPathSample();
+
+	if (!followMode)
+	{
+		INC_DWORD_STAT(STAT_ActiveTours);
+	}
 	followMode = true;
+	SetComponentTickEnabled(true);
+
+	if (prefetcher != NULL)
+	{
+		prefetcher->startPrefetching(this);
+	}
 	//UE_LOG(Kilograph, Log, TEXT("STARTED CAMERA FOLLOWING WHOOOO"));
 }
 
 void UCameraFollow::stopFollowing()
 {
+	if (followMode)
+	{
+		player->GetCharacterMovement()->SetComponentTickEnabled(true);
+		player->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		DEC_DWORD_STAT(STAT_ActiveTours);
+	}
 	followMode = false;
-}
+	SetComponentTickEnabled(false);
 
+	if (prefetcher != NULL)
+	{
+		prefetcher->stopPrefetching();
+	}
+}
@@ -3,9 +3,12 @@
 #pragma once
 
 #include "Components/ActorComponent.h"
+#include "TourPath.h"
 #include "CameraFollow.generated.h"
 
 class AKilographUnrealAppCharacter;
+class UTourPrefetcher;
+class UTourAsset;
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class KILOGRAPHUNREALAPP_API UCameraFollow : public UActorComponent
@@ -31,15 +34,89 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Bake the spline of every tour asset, or of the path elements under the owner when there are none
+	void bakePath();
+
+	// Gather the path elements attached under the owner, in attachment order
+	void gatherPathElements(TArray<AActor *> &outElements) const;
+
+	// Switch to another tour asset, restarting from its beginning if the tour is running
+	UFUNCTION(BlueprintCallable, Category = Tour)
+	bool selectTour(int32 tourIndex);
+
+	// Number of tour assets to choose from
+	UFUNCTION(BlueprintCallable, Category = Tour)
+	int32 getNumTours() const { return tourPaths.Num(); }
+
+	// Name of the current tour, the tour asset's name or the owner's for a scene path
+	FString getTourName() const;
+
+	// Distance the player has travelled along the tour loop
+	float getDistanceAlongPath() const { return distanceAlongPath; }
+
+	// Control point the player last passed, and how long it still rests there
+	int32 getCurrentControlPoint() const { return currentControlPoint; }
+	float getDwellRemaining() const { return dwellRemaining; }
+
+	// Move along the current tour, resting at control points that ask for it, without moving the player
+	void advance(float stepTime);
+
+	// Speed the tour travels at a distance along the current tour, blending the control points' own speeds
+	float getSpeedAtDistance(float distance) const;
+
+	// The baked spline of the current tour
+	const FTourPath &getTourPath() const { return currentTour != INDEX_NONE ? tourPaths[currentTour] : tourPath; }
+
+	// Tours to choose from, baked from the scene by the TourImport commandlet; the path elements under the owner are used if empty
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tour)
+	TArray<UTourAsset *> tours;
+
+	// Speed at which the player travels along the tour, in cm/sec
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tour)
+	float tourSpeed;
+
+	// Turn the player's view to face along the path while touring
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tour)
+	bool orientAlongPath;
+
+	// Rate at which the tour is stepped in fixed increments, 0 steps once per frame with the frame's delta
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tour)
+	float fixedStepRate;
+
+	// Most fixed steps taken in a single frame, any time beyond that is dropped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Tour)
+	int32 maxSubsteps;
+
 private:
+	// Move the player to the current distance along the path
+	void applyPathSample();
+
 	// The player that will be affected by this camera path
 	AKilographUnrealAppCharacter *player;
 
+	// Optional prefetcher on the same actor, run while touring
+	UTourPrefetcher *prefetcher;
+
 	// The elements of the camera path
 	TArray<AActor *> cameraPathElements;
 
-	// The current array index
-	int currentIndex;
+	// Spline baked through the path elements
+	FTourPath tourPath;
+
+	// Splines baked from the tour assets, the assets they were baked from, and the one being followed, INDEX_NONE for the path elements
+	TArray<FTourPath> tourPaths;
+	TArray<UTourAsset *> tourAssets;
+	int32 currentTour;
+
+	// Control point the player last passed, and how long it still rests there
+	int32 currentControlPoint;
+	float dwellRemaining;
+
+	// Current distance along the baked path
+	float distanceAlongPath;
+
+	// Time not yet consumed by fixed rate steps
+	float stepAccumulator;
 
 	// Determines whether the player is in follow mode or not
 	bool followMode;
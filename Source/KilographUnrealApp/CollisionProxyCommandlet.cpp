@@ -0,0 +1,448 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "CollisionProxyCommandlet.h"
+#include "VisibilityBakeCommandlet.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "StaticMeshResources.h"
+#include "Async/ParallelFor.h"
+#include "EngineUtils.h"
+#include "Json.h"
+
+// Bits of each voxel coordinate in a voxel's key, z above y above x so sorted keys run in x, then y, then z order
+static const int32 VoxelKeyBits = 21;
+static const int32 MaxVoxelsPerAxis = 1 << VoxelKeyBits;
+
+// Thinnest box, so a flat mesh still gets a slab when its boxes are clipped to its bounds
+static const float MinBoxThickness = 1.0f;
+
+// Rough size of a cooked triangle mesh, a position per vertex and indices plus tree per triangle
+static const int32 TriangleMeshBytesPerVertex = 12;
+static const int32 TriangleMeshBytesPerTriangle = 16;
+
+// Traces timed by -MeasureQueries, always the same ones
+static const int32 NumMeasuredQueries = 4096;
+static const int32 MeasuredQuerySeed = 0x4B696C6F;
+
+UCollisionProxyCommandlet::UCollisionProxyCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCollisionProxyCommandlet::Main(const FString &Params)
+{
+#if WITH_EDITOR
+	FString mapName;
+	if (!FParse::Value(*Params, TEXT("Map="), mapName))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Usage: -run=CollisionProxy -Map=<map> [-VoxelSize=10] [-MaxBoxes=512] [-MaxVolumeRatio=4] [-Overwrite] [-Save] [-Report=<file>] [-MeasureQueries]"));
+		return 1;
+	}
+
+	float voxelSize = 10.0f;
+	FParse::Value(*Params, TEXT("VoxelSize="), voxelSize);
+	voxelSize = FMath::Max(voxelSize, 1.0f);
+	int32 maxBoxes = 512;
+	FParse::Value(*Params, TEXT("MaxBoxes="), maxBoxes);
+	float maxVolumeRatio = 4.0f;
+	FParse::Value(*Params, TEXT("MaxVolumeRatio="), maxVolumeRatio);
+	FString reportPath = FPaths::GameSavedDir() / TEXT("CollisionProxy") / FPackageName::GetShortName(mapName) + TEXT(".json");
+	FParse::Value(*Params, TEXT("Report="), reportPath);
+	const bool overwrite = FParse::Param(*Params, TEXT("Overwrite"));
+	const bool save = FParse::Param(*Params, TEXT("Save"));
+	const bool measure = FParse::Param(*Params, TEXT("MeasureQueries"));
+
+	UWorld *world = UVisibilityBakeCommandlet::loadWorld(mapName);
+	if (world == NULL)
+	{
+		return 1;
+	}
+
+	// Every mesh placed in the map once, in path order so the output doesn't depend on the actor order
+	TSet<UStaticMesh *> meshSet;
+	FBox worldBounds(0);
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		TInlineComponentArray<UStaticMeshComponent *> components(*actorIt);
+		for (int32 componentIndex = 0; componentIndex < components.Num(); componentIndex++)
+		{
+			UStaticMesh *mesh = components[componentIndex]->StaticMesh;
+			if (mesh != NULL)
+			{
+				meshSet.Add(mesh);
+				worldBounds += components[componentIndex]->Bounds.GetBox();
+			}
+		}
+	}
+
+	TArray<UStaticMesh *> meshes = meshSet.Array();
+	meshes.Sort([](const UStaticMesh &first, const UStaticMesh &second) { return first.GetPathName() < second.GetPathName(); });
+
+	TArray<FMeshProxy> proxies;
+	int32 skipped = 0;
+	for (int32 meshIndex = 0; meshIndex < meshes.Num(); meshIndex++)
+	{
+		UStaticMesh *mesh = meshes[meshIndex];
+		const bool authored = mesh->BodySetup != NULL && mesh->BodySetup->AggGeom.GetElementCount() > 0;
+		if (mesh->RenderData == NULL || mesh->RenderData->LODResources.Num() == 0 ||
+			(!overwrite && (authored || mesh->GetPathName().StartsWith(TEXT("/Engine/")))))
+		{
+			skipped++;
+			continue;
+		}
+
+		// Copied out here so building the proxies touches no objects
+		const FStaticMeshLODResources &lod = mesh->RenderData->LODResources[0];
+		FMeshProxy &proxy = proxies[proxies.AddDefaulted()];
+		proxy.mesh = mesh;
+		proxy.name = mesh->GetPathName();
+		proxy.vertices.Reserve(lod.PositionVertexBuffer.GetNumVertices());
+		for (uint32 vertexIndex = 0; vertexIndex < lod.PositionVertexBuffer.GetNumVertices(); vertexIndex++)
+		{
+			proxy.vertices.Add(lod.PositionVertexBuffer.VertexPosition(vertexIndex));
+		}
+		lod.IndexBuffer.GetCopy(proxy.indices);
+		proxy.bounds = FBox(proxy.vertices);
+	}
+
+	UE_LOG(Kilograph, Display, TEXT("Building collision proxies of %d meshes, %d skipped"), proxies.Num(), skipped);
+
+	const double queryTimeBefore = measure ? measureQueries(world, worldBounds) : 0.0;
+
+	ParallelFor(proxies.Num(), [&proxies, voxelSize, maxVolumeRatio](int32 proxyIndex)
+	{
+		buildProxy(proxies[proxyIndex], voxelSize, maxVolumeRatio);
+	});
+
+	// The body setups are only touched here, one mesh at a time
+	int32 failures = 0;
+	for (int32 proxyIndex = 0; proxyIndex < proxies.Num(); proxyIndex++)
+	{
+		FMeshProxy &proxy = proxies[proxyIndex];
+		applyProxy(proxy, maxBoxes);
+		UE_LOG(Kilograph, Display, TEXT("%s: %d triangles, %s"), *proxy.name, proxy.indices.Num() / 3,
+			proxy.fallback ? TEXT("falls back to complex collision") : *FString::Printf(TEXT("%d boxes"), proxy.boxes.Num()));
+
+		if (save)
+		{
+			UPackage *package = proxy.mesh->GetOutermost();
+			const FString fileName = FPackageName::LongPackageNameToFilename(package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (!UPackage::SavePackage(package, proxy.mesh, RF_Standalone, *fileName))
+			{
+				UE_LOG(Kilograph, Error, TEXT("Failed to save %s"), *fileName);
+				failures++;
+			}
+		}
+	}
+
+	double queryTimeAfter = 0.0;
+	if (measure)
+	{
+		// The components pick up the new collision when their physics state is made again
+		for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+		{
+			TInlineComponentArray<UStaticMeshComponent *> components(*actorIt);
+			for (int32 componentIndex = 0; componentIndex < components.Num(); componentIndex++)
+			{
+				components[componentIndex]->RecreatePhysicsState();
+			}
+		}
+		queryTimeAfter = measureQueries(world, worldBounds);
+		UE_LOG(Kilograph, Display, TEXT("Complex traces took %.2f us before and %.2f us after"), queryTimeBefore, queryTimeAfter);
+	}
+
+	if (!writeReport(reportPath, mapName, proxies, voxelSize, maxBoxes, maxVolumeRatio, queryTimeBefore, queryTimeAfter))
+	{
+		failures++;
+	}
+
+	UVisibilityBakeCommandlet::unloadWorld(world);
+	return failures > 0 ? 1 : 0;
+#else
+	UE_LOG(Kilograph, Error, TEXT("Collision proxies can only be built from an editor build"));
+	return 1;
+#endif
+}
+
+void UCollisionProxyCommandlet::buildProxy(FMeshProxy &proxy, float voxelSize, float maxVolumeRatio)
+{
+	const FVector size = proxy.bounds.IsValid ? proxy.bounds.GetSize() : FVector::ZeroVector;
+	if (proxy.indices.Num() < 3 || !proxy.bounds.IsValid || size.GetMax() / voxelSize >= MaxVoxelsPerAxis - 1)
+	{
+		proxy.fallback = true;
+		return;
+	}
+
+	// Only the voxels the surface passes through, kept sparse as a building's shell is a sliver of its bounds
+	const FVector origin = proxy.bounds.Min;
+	auto voxelKey = [](int32 x, int32 y, int32 z) { return ((uint64)z << (VoxelKeyBits * 2)) | ((uint64)y << VoxelKeyBits) | (uint64)x; };
+	TSet<uint64> surface;
+	float area = 0.0f;
+
+	// Mark every voxel a triangle passes through, halving it across its longest edge until no edge is longer than half
+	// a voxel, then marking the voxels its pieces' bounds overlap. Work follows the voxels touched, however large the triangle
+	TArray<FVector, TInlineAllocator<96> > pending;
+	for (int32 index = 0; index + 2 < proxy.indices.Num(); index += 3)
+	{
+		const FVector &a = proxy.vertices[proxy.indices[index]];
+		const FVector &b = proxy.vertices[proxy.indices[index + 1]];
+		const FVector &c = proxy.vertices[proxy.indices[index + 2]];
+		area += ((b - a) ^ (c - a)).Size() * 0.5f;
+
+		pending.Reset();
+		pending.Add((a - origin) / voxelSize);
+		pending.Add((b - origin) / voxelSize);
+		pending.Add((c - origin) / voxelSize);
+		while (pending.Num() > 0)
+		{
+			const FVector first = pending[pending.Num() - 3];
+			const FVector second = pending[pending.Num() - 2];
+			const FVector third = pending[pending.Num() - 1];
+			pending.RemoveAt(pending.Num() - 3, 3, false);
+
+			const float edges[3] = { (second - first).SizeSquared(), (third - second).SizeSquared(), (first - third).SizeSquared() };
+			const int32 longest = edges[0] >= edges[1] && edges[0] >= edges[2] ? 0 : edges[1] >= edges[2] ? 1 : 2;
+			if (edges[longest] > 0.25f)
+			{
+				// Split the longest edge at its middle, the corner opposite it goes to both halves
+				const FVector corners[3] = { first, second, third };
+				const FVector &start = corners[longest];
+				const FVector &end = corners[(longest + 1) % 3];
+				const FVector &opposite = corners[(longest + 2) % 3];
+				const FVector middle = (start + end) * 0.5f;
+				pending.Add(start);
+				pending.Add(middle);
+				pending.Add(opposite);
+				pending.Add(middle);
+				pending.Add(end);
+				pending.Add(opposite);
+				continue;
+			}
+
+			const FVector low = first.ComponentMin(second).ComponentMin(third);
+			const FVector high = first.ComponentMax(second).ComponentMax(third);
+			for (int32 z = FMath::Max(FMath::FloorToInt(low.Z), 0); z <= FMath::Max(FMath::FloorToInt(high.Z), 0); z++)
+			{
+				for (int32 y = FMath::Max(FMath::FloorToInt(low.Y), 0); y <= FMath::Max(FMath::FloorToInt(high.Y), 0); y++)
+				{
+					for (int32 x = FMath::Max(FMath::FloorToInt(low.X), 0); x <= FMath::Max(FMath::FloorToInt(high.X), 0); x++)
+					{
+						surface.Add(voxelKey(x, y, z));
+					}
+				}
+			}
+		}
+	}
+
+	// Voxels much bulkier than the surface they stand for mean detail finer than the voxels, the boxes would be nothing like the mesh
+	proxy.volumeRatio = area > 0.0f ? surface.Num() * voxelSize * voxelSize / area : BIG_NUMBER;
+	if (proxy.volumeRatio > maxVolumeRatio)
+	{
+		proxy.fallback = true;
+		return;
+	}
+
+	// Grow a box from each uncovered surface voxel along x, then y, then z, as far as the voxels stay surface.
+	// The voxels are visited in key order, so the boxes don't depend on the order the set holds them in
+	TArray<uint64> keys = surface.Array();
+	keys.Sort();
+	TSet<uint64> covered;
+	auto isFree = [&surface, &covered, &voxelKey](int32 x, int32 y, int32 z)
+	{
+		const uint64 key = voxelKey(x, y, z);
+		return surface.Contains(key) && !covered.Contains(key);
+	};
+
+	const uint64 axisMask = MaxVoxelsPerAxis - 1;
+	const FBox clipBounds = proxy.bounds.ExpandBy(MinBoxThickness * 0.5f);
+	for (int32 keyIndex = 0; keyIndex < keys.Num(); keyIndex++)
+	{
+		if (covered.Contains(keys[keyIndex]))
+		{
+			continue;
+		}
+
+		const int32 x = (int32)(keys[keyIndex] & axisMask);
+		const int32 y = (int32)((keys[keyIndex] >> VoxelKeyBits) & axisMask);
+		const int32 z = (int32)(keys[keyIndex] >> (VoxelKeyBits * 2));
+
+		int32 endX = x + 1;
+		while (isFree(endX, y, z))
+		{
+			endX++;
+		}
+
+		int32 endY = y + 1;
+		for (bool grows = true; grows; )
+		{
+			for (int32 rowX = x; rowX < endX && grows; rowX++)
+			{
+				grows = isFree(rowX, endY, z);
+			}
+			endY += grows ? 1 : 0;
+		}
+
+		int32 endZ = z + 1;
+		for (bool grows = true; grows; )
+		{
+			for (int32 sliceY = y; sliceY < endY && grows; sliceY++)
+			{
+				for (int32 sliceX = x; sliceX < endX && grows; sliceX++)
+				{
+					grows = isFree(sliceX, sliceY, endZ);
+				}
+			}
+			endZ += grows ? 1 : 0;
+		}
+
+		for (int32 boxZ = z; boxZ < endZ; boxZ++)
+		{
+			for (int32 boxY = y; boxY < endY; boxY++)
+			{
+				for (int32 boxX = x; boxX < endX; boxX++)
+				{
+					covered.Add(voxelKey(boxX, boxY, boxZ));
+				}
+			}
+		}
+
+		// Clipped to the mesh bounds, voxels stick out past the faces they hold, so floors stay where they were
+		const FBox box(origin + FVector(x, y, z) * voxelSize, origin + FVector(endX, endY, endZ) * voxelSize);
+		proxy.boxes.Add(FBox(box.Min.ComponentMax(clipBounds.Min), box.Max.ComponentMin(clipBounds.Max)));
+	}
+}
+
+void UCollisionProxyCommandlet::applyProxy(FMeshProxy &proxy, int32 maxBoxes)
+{
+	proxy.mesh->CreateBodySetup();
+	UBodySetup *bodySetup = proxy.mesh->BodySetup;
+	bodySetup->Modify();
+
+	// Past the box budget the shell would cost the physics scene more than the triangles it replaces
+	if (!proxy.fallback && proxy.boxes.Num() > maxBoxes)
+	{
+		proxy.fallback = true;
+	}
+
+	if (proxy.fallback)
+	{
+		// Too fine for the voxels or too many boxes, every query goes to the triangles instead
+		bodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+	}
+	else
+	{
+		// The boxes are the shell as it is, complex queries use them too and the triangle mesh is no longer cooked
+		bodySetup->AggGeom.EmptyElements();
+		for (int32 boxIndex = 0; boxIndex < proxy.boxes.Num(); boxIndex++)
+		{
+			const FVector extent = proxy.boxes[boxIndex].GetSize();
+			FKBoxElem box(extent.X, extent.Y, extent.Z);
+			box.Center = proxy.boxes[boxIndex].GetCenter();
+			bodySetup->AggGeom.BoxElems.Add(box);
+		}
+		bodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+	}
+
+	bodySetup->InvalidatePhysicsData();
+	bodySetup->CreatePhysicsMeshes();
+	proxy.mesh->MarkPackageDirty();
+}
+
+double UCollisionProxyCommandlet::measureQueries(UWorld *world, const FBox &bounds)
+{
+	if (!bounds.IsValid)
+	{
+		return 0.0;
+	}
+
+	FRandomStream random(MeasuredQuerySeed);
+	FCollisionQueryParams traceParams(FName(TEXT("CollisionProxy")), true);
+	FHitResult hit(ForceInit);
+
+	const double start = FPlatformTime::Seconds();
+	for (int32 queryIndex = 0; queryIndex < NumMeasuredQueries; queryIndex++)
+	{
+		const FVector traceStart(random.FRandRange(bounds.Min.X, bounds.Max.X), random.FRandRange(bounds.Min.Y, bounds.Max.Y), random.FRandRange(bounds.Min.Z, bounds.Max.Z));
+		const FVector traceEnd(random.FRandRange(bounds.Min.X, bounds.Max.X), random.FRandRange(bounds.Min.Y, bounds.Max.Y), random.FRandRange(bounds.Min.Z, bounds.Max.Z));
+		world->LineTraceSingleByChannel(hit, traceStart, traceEnd, ECC_Visibility, traceParams);
+	}
+	return (FPlatformTime::Seconds() - start) * 1000000.0 / NumMeasuredQueries;
+}
+
+bool UCollisionProxyCommandlet::writeReport(const FString &path, const FString &mapName, const TArray<FMeshProxy> &proxies, float voxelSize, int32 maxBoxes,
+	float maxVolumeRatio, double queryTimeBefore, double queryTimeAfter)
+{
+	FString output;
+	TSharedRef<TJsonWriter<> > writer = TJsonWriterFactory<>::Create(&output);
+
+	int32 totalTriangles = 0;
+	int32 totalBoxes = 0;
+	int32 totalFallbacks = 0;
+	int64 bytesBefore = 0;
+	int64 bytesAfter = 0;
+
+	writer->WriteObjectStart();
+	writer->WriteValue(TEXT("map"), mapName);
+	writer->WriteValue(TEXT("voxelSize"), voxelSize);
+	writer->WriteValue(TEXT("maxBoxes"), maxBoxes);
+	writer->WriteValue(TEXT("maxVolumeRatio"), maxVolumeRatio);
+
+	writer->WriteArrayStart(TEXT("meshes"));
+	for (int32 proxyIndex = 0; proxyIndex < proxies.Num(); proxyIndex++)
+	{
+		const FMeshProxy &proxy = proxies[proxyIndex];
+		const int32 triangles = proxy.indices.Num() / 3;
+		const int64 triangleBytes = (int64)proxy.vertices.Num() * TriangleMeshBytesPerVertex + (int64)triangles * TriangleMeshBytesPerTriangle;
+		const int64 proxyBytes = proxy.fallback ? triangleBytes : (int64)proxy.boxes.Num() * sizeof(FKBoxElem);
+
+		writer->WriteObjectStart();
+		writer->WriteValue(TEXT("name"), proxy.name);
+		writer->WriteValue(TEXT("triangles"), triangles);
+		writer->WriteValue(TEXT("boxes"), proxy.boxes.Num());
+		writer->WriteValue(TEXT("volumeRatio"), proxy.volumeRatio);
+		writer->WriteValue(TEXT("fallback"), proxy.fallback);
+		writer->WriteValue(TEXT("bytesBefore"), (double)triangleBytes);
+		writer->WriteValue(TEXT("bytesAfter"), (double)proxyBytes);
+		writer->WriteObjectEnd();
+
+		totalTriangles += triangles;
+		totalBoxes += proxy.boxes.Num();
+		totalFallbacks += proxy.fallback ? 1 : 0;
+		bytesBefore += triangleBytes;
+		bytesAfter += proxyBytes;
+	}
+	writer->WriteArrayEnd();
+
+	writer->WriteObjectStart(TEXT("totals"));
+	writer->WriteValue(TEXT("meshes"), proxies.Num());
+	writer->WriteValue(TEXT("fallbacks"), totalFallbacks);
+	writer->WriteValue(TEXT("triangles"), totalTriangles);
+	writer->WriteValue(TEXT("boxes"), totalBoxes);
+	writer->WriteValue(TEXT("bytesBefore"), (double)bytesBefore);
+	writer->WriteValue(TEXT("bytesAfter"), (double)bytesAfter);
+	writer->WriteObjectEnd();
+
+	if (queryTimeBefore > 0.0)
+	{
+		writer->WriteObjectStart(TEXT("queries"));
+		writer->WriteValue(TEXT("microsecondsBefore"), queryTimeBefore);
+		writer->WriteValue(TEXT("microsecondsAfter"), queryTimeAfter);
+		writer->WriteObjectEnd();
+	}
+
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to write the collision proxy report to %s"), *path);
+		return false;
+	}
+
+	UE_LOG(Kilograph, Display, TEXT("%d meshes, %d fall back to complex collision, about %lld KB of collision down to %lld KB, report in %s"),
+		proxies.Num(), totalFallbacks, bytesBefore / 1024, bytesAfter / 1024, *path);
+	return true;
+}
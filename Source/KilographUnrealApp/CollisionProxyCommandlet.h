@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "CollisionProxyCommandlet.generated.h"
+
+/**
+ * Replaces the collision of the static meshes placed in a map with a simplified shell of each
+ * mesh. The voxels its triangles pass through are found at a fixed size of -VoxelSize cm, only
+ * the surface, so rooms stay open and can be walked through, and merged greedily into boxes, the
+ * meshes spread over every core. The boxes become the mesh's simple collision as they are, and
+ * proxied meshes answer complex queries with them as well, so neither the walk nor the hotspot
+ * traces touch their triangles. Meshes too fine for the voxels, whose boxes hold over
+ * -MaxVolumeRatio times the volume of a voxel thick shell over their triangles, or needing more
+ * than -MaxBoxes boxes, are tagged to fall back to their triangles for all queries. Meshes with
+ * authored simple collision and engine content are left alone unless -Overwrite.
+ *
+ * Usage: UE4Editor-Cmd <Project> -run=CollisionProxy -Map=/Game/Maps/Building
+ *		[-VoxelSize=10] [-MaxBoxes=512] [-MaxVolumeRatio=4]
+ *		[-Overwrite] [-Save] [-Report=<file>] [-MeasureQueries]
+ *
+ * Meshes are processed in path order and the voxelization uses no randomness or timing, so the
+ * same meshes and settings always give the same collision and report, and the results can be
+ * cached between content builds. The report holds the triangle and box counts and the estimated
+ * collision memory of every mesh. -MeasureQueries adds the time of a fixed set of traces through
+ * the map before and after, the only part of the report that varies between runs.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UCollisionProxyCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCollisionProxyCommandlet();
+
+	// Build the proxies of the map given on the command line
+	virtual int32 Main(const FString &Params) override;
+
+private:
+	// A mesh's triangles and the proxy built from them
+	struct FMeshProxy
+	{
+		UStaticMesh *mesh;
+		FString name;
+		TArray<FVector> vertices;
+		TArray<uint32> indices;
+		FBox bounds;
+
+		// Boxes covering the surface voxels, and their volume against a voxel thick shell over the triangles
+		TArray<FBox> boxes;
+		float volumeRatio;
+
+		// Whether the voxels are too coarse for the mesh, or its boxes too many, so it falls back to its triangles
+		bool fallback;
+
+		FMeshProxy() : mesh(NULL), bounds(0), volumeRatio(0.0f), fallback(false) {}
+	};
+
+	// Voxelize a mesh's surface and cover it with boxes, touches no objects so it can run on any thread
+	static void buildProxy(FMeshProxy &proxy, float voxelSize, float maxVolumeRatio);
+
+	// Replace a mesh's collision with its boxes, or set it to use its triangles, on the game thread only
+	static void applyProxy(FMeshProxy &proxy, int32 maxBoxes);
+
+	// Time in microseconds of an average complex trace through the bounds, the same traces every run
+	static double measureQueries(UWorld *world, const FBox &bounds);
+
+	// Write the counts and memory of every mesh, and the query times if they were measured
+	static bool writeReport(const FString &path, const FString &mapName, const TArray<FMeshProxy> &proxies, float voxelSize, int32 maxBoxes,
+		float maxVolumeRatio, double queryTimeBefore, double queryTimeAfter);
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "HotspotComponent.h"
+#include "HotspotRegistry.h"
+
+
+// Sets default values for this component's properties
+UHotspotComponent::UHotspotComponent()
+{
+	// Hotspots only react to taps, they never need to tick
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+// Called when the game starts
+void UHotspotComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UHotspotRegistry *registry = UHotspotRegistry::get(this);
+	if (registry != NULL)
+	{
+		registry->registerHotspot(this);
+	}
+}
+
+// Called when the component is removed from play
+void UHotspotComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UHotspotRegistry *registry = UHotspotRegistry::get(this);
+	if (registry != NULL)
+	{
+		registry->unregisterHotspot(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHotspotComponent::press()
+{
+	receivePress();
+	onPressed.Broadcast(this);
+}
+
+FBox UHotspotComponent::getBounds() const
+{
+	return GetOwner()->GetComponentsBoundingBox(true);
+}
+
+void UHotspotComponent::refreshBounds()
+{
+	UHotspotRegistry *registry = UHotspotRegistry::get(this);
+	if (registry != NULL)
+	{
+		registry->markDirty();
+	}
+}
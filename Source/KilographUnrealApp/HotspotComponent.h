@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "HotspotComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHotspotPressedSignature, class UHotspotComponent*, hotspot);
+
+/**
+ * Makes its owning actor tappable. Hotspots register their bounds with the world's hotspot
+ * registry when play begins, and taps resolved against the registry call press().
+ */
+UCLASS( ClassGroup=(Custom), Blueprintable, meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UHotspotComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UHotspotComponent();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Activate the hotspot
+	void press();
+
+	// World space bounds used to resolve taps against this hotspot
+	FBox getBounds() const;
+
+	// Re-read the owner's bounds after it has been moved or resized
+	UFUNCTION(BlueprintCallable, Category = "Hotspot")
+	void refreshBounds();
+
+	// Text shown next to the hotspot, hotspots without one aren't labelled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hotspot")
+	FText label;
+
+	// Fired when the user taps the hotspot
+	UPROPERTY(BlueprintAssignable, Category = "Hotspot")
+	FHotspotPressedSignature onPressed;
+
+	// Blueprint response to the user tapping the hotspot
+	UFUNCTION(BlueprintImplementableEvent, Category = "Hotspot")
+	void receivePress();
+};
@@ -0,0 +1,303 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "HotspotLabels.h"
+#include "HotspotRegistry.h"
+#include "HotspotComponent.h"
+#include "Engine/Canvas.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hotspot Label Layout"), STAT_HotspotLabelLayout, STATGROUP_Kilograph);
+DECLARE_CYCLE_STAT(TEXT("Hotspot Label Draw"), STAT_HotspotLabelDraw, STATGROUP_Kilograph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hotspot Labels"), STAT_HotspotLabels, STATGROUP_Kilograph);
+
+// Anything nearer the camera than this is treated as behind it
+static const float LabelNearPlane = 10.0f;
+
+// Grid cells are small enough that any two points in a cell lie within the cluster radius
+static const float ClusterCellScale = 0.7071f;
+
+// Cells searched either side of a point's own cell for a cluster to join
+static const int32 ClusterCellReach = 2;
+
+FHotspotLabels::FHotspotLabels()
+{
+	clusterRadius = 48.0f;
+	maxLabels = 64;
+	maxDistance = 5000.0f;
+	padding = 4.0f;
+	maxCacheAge = 0.5f;
+	numAnchors = 0;
+	anchorsVersion = 0;
+	hasLayout = false;
+	layoutFov = 0.0f;
+	layoutTime = 0.0;
+}
+
+void FHotspotLabels::draw(UCanvas *canvas, UFont *font, UHotspotRegistry *registry, const FVector &viewLocation, const FRotator &viewRotation, float fovDegrees)
+{
+	if (canvas == NULL || font == NULL || registry == NULL)
+	{
+		return;
+	}
+
+	const FVector2D canvasSize(canvas->ClipX, canvas->ClipY);
+	const double now = FPlatformTime::Seconds();
+
+	// A still camera over still hotspots keeps the last layout
+	const bool hotspotsChanged = !hasLayout || anchorsVersion != registry->getVersion();
+	if (hotspotsChanged ||
+		now - layoutTime > maxCacheAge ||
+		!layoutLocation.Equals(viewLocation, 0.1f) ||
+		!layoutRotation.Equals(viewRotation, 0.01f) ||
+		layoutFov != fovDegrees ||
+		layoutCanvasSize != canvasSize)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HotspotLabelLayout);
+
+		if (hotspotsChanged)
+		{
+			refreshAnchors(registry);
+		}
+		projectAnchors(viewLocation, viewRotation, fovDegrees, canvasSize);
+		layoutLabels(canvasSize, font);
+
+		hasLayout = true;
+		layoutLocation = viewLocation;
+		layoutRotation = viewRotation;
+		layoutFov = fovDegrees;
+		layoutCanvasSize = canvasSize;
+		layoutTime = now;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HotspotLabelDraw);
+	INC_DWORD_STAT_BY(STAT_HotspotLabels, labels.Num());
+
+	if (labels.Num() == 0)
+	{
+		return;
+	}
+
+	// Every background in one item, then every text in one font, so each is a single batch
+	FCanvasTriangleItem backgrounds(backgroundTriangles, GWhiteTexture);
+	backgrounds.BlendMode = SE_BLEND_Translucent;
+	canvas->DrawItem(backgrounds);
+
+	canvas->SetDrawColor(FColor::White);
+	for (int32 labelIndex = 0; labelIndex < labels.Num(); labelIndex++)
+	{
+		const FLabel &label = labels[labelIndex];
+		canvas->DrawText(font, label.text, label.position.X + padding, label.position.Y + padding);
+	}
+}
+
+void FHotspotLabels::refreshAnchors(UHotspotRegistry *registry)
+{
+	anchorsVersion = registry->getVersion();
+
+	const TArray<UHotspotComponent *> &hotspots = registry->getHotspots();
+	numAnchors = 0;
+	anchorHotspots.Reset();
+	anchorTexts.Reset();
+
+	// Padded so the projection can always read four anchors at a time
+	const int32 paddedNum = Align(hotspots.Num(), 4);
+	anchorX.SetNumZeroed(paddedNum);
+	anchorY.SetNumZeroed(paddedNum);
+	anchorZ.SetNumZeroed(paddedNum);
+	depths.SetNumZeroed(paddedNum);
+	screenX.SetNumZeroed(paddedNum);
+	screenY.SetNumZeroed(paddedNum);
+
+	for (int32 hotspotIndex = 0; hotspotIndex < hotspots.Num(); hotspotIndex++)
+	{
+		UHotspotComponent *hotspot = hotspots[hotspotIndex];
+		// Hotspots without a label of their own aren't labelled, the owner's name means nothing to a visitor
+		if (hotspot == NULL || hotspot->GetOwner() == NULL || hotspot->label.IsEmpty())
+		{
+			continue;
+		}
+
+		// Labels sit above the middle of the hotspot
+		const FBox bounds = hotspot->getBounds();
+		const FVector anchor = bounds.IsValid ? FVector(bounds.GetCenter().X, bounds.GetCenter().Y, bounds.Max.Z) : hotspot->GetOwner()->GetActorLocation();
+		anchorX[numAnchors] = anchor.X;
+		anchorY[numAnchors] = anchor.Y;
+		anchorZ[numAnchors] = anchor.Z;
+		anchorHotspots.Add(hotspot);
+		anchorTexts.Add(hotspot->label.ToString());
+		numAnchors++;
+	}
+}
+
+void FHotspotLabels::projectAnchors(const FVector &viewLocation, const FRotator &viewRotation, float fovDegrees, const FVector2D &canvasSize)
+{
+	const FRotationMatrix viewMatrix(viewRotation);
+	const FVector forward = viewMatrix.GetScaledAxis(EAxis::X);
+	const FVector right = viewMatrix.GetScaledAxis(EAxis::Y);
+	const FVector up = viewMatrix.GetScaledAxis(EAxis::Z);
+	const float scale = canvasSize.X * 0.5f / FMath::Tan(FMath::DegreesToRadians(FMath::Max(fovDegrees, 1.0f) * 0.5f));
+
+	const VectorRegister originX = VectorSetFloat1(viewLocation.X);
+	const VectorRegister originY = VectorSetFloat1(viewLocation.Y);
+	const VectorRegister originZ = VectorSetFloat1(viewLocation.Z);
+	const VectorRegister forwardX = VectorSetFloat1(forward.X);
+	const VectorRegister forwardY = VectorSetFloat1(forward.Y);
+	const VectorRegister forwardZ = VectorSetFloat1(forward.Z);
+	const VectorRegister rightX = VectorSetFloat1(right.X * scale);
+	const VectorRegister rightY = VectorSetFloat1(right.Y * scale);
+	const VectorRegister rightZ = VectorSetFloat1(right.Z * scale);
+	const VectorRegister upX = VectorSetFloat1(-up.X * scale);
+	const VectorRegister upY = VectorSetFloat1(-up.Y * scale);
+	const VectorRegister upZ = VectorSetFloat1(-up.Z * scale);
+	const VectorRegister centerX = VectorSetFloat1(canvasSize.X * 0.5f);
+	const VectorRegister centerY = VectorSetFloat1(canvasSize.Y * 0.5f);
+	const VectorRegister nearPlane = VectorSetFloat1(LabelNearPlane);
+
+	for (int32 anchorIndex = 0; anchorIndex < numAnchors; anchorIndex += 4)
+	{
+		const VectorRegister dx = VectorSubtract(VectorLoad(&anchorX[anchorIndex]), originX);
+		const VectorRegister dy = VectorSubtract(VectorLoad(&anchorY[anchorIndex]), originY);
+		const VectorRegister dz = VectorSubtract(VectorLoad(&anchorZ[anchorIndex]), originZ);
+
+		const VectorRegister depth = VectorMultiplyAdd(dz, forwardZ, VectorMultiplyAdd(dy, forwardY, VectorMultiply(dx, forwardX)));
+		const VectorRegister viewX = VectorMultiplyAdd(dz, rightZ, VectorMultiplyAdd(dy, rightY, VectorMultiply(dx, rightX)));
+		const VectorRegister viewY = VectorMultiplyAdd(dz, upZ, VectorMultiplyAdd(dy, upY, VectorMultiply(dx, upX)));
+
+		// Clamped so anchors behind the camera divide safely, they are culled by depth afterwards
+		const VectorRegister inverseDepth = VectorReciprocalAccurate(VectorMax(depth, nearPlane));
+		VectorStore(depth, &depths[anchorIndex]);
+		VectorStore(VectorMultiplyAdd(viewX, inverseDepth, centerX), &screenX[anchorIndex]);
+		VectorStore(VectorMultiplyAdd(viewY, inverseDepth, centerY), &screenY[anchorIndex]);
+	}
+}
+
+void FHotspotLabels::layoutLabels(const FVector2D &canvasSize, UFont *font)
+{
+	labels.Reset();
+	backgroundTriangles.Reset();
+
+	// Anchors in front of the camera, in range, on screen and shown, nearest first
+	TArray<int32> candidates;
+	for (int32 anchorIndex = 0; anchorIndex < numAnchors; anchorIndex++)
+	{
+		if (depths[anchorIndex] <= LabelNearPlane || depths[anchorIndex] > maxDistance ||
+			screenX[anchorIndex] < 0.0f || screenX[anchorIndex] > canvasSize.X ||
+			screenY[anchorIndex] < 0.0f || screenY[anchorIndex] > canvasSize.Y)
+		{
+			continue;
+		}
+
+		const UHotspotComponent *hotspot = anchorHotspots[anchorIndex].Get();
+		if (hotspot != NULL && !hotspot->GetOwner()->bHidden)
+		{
+			candidates.Add(anchorIndex);
+		}
+	}
+	candidates.Sort([this](int32 first, int32 second) { return depths[first] < depths[second]; });
+
+	// Each anchor joins the nearest cluster within the radius, or starts one if there is room
+	const float cellSize = FMath::Max(clusterRadius * ClusterCellScale, 1.0f);
+	const float radiusSquared = clusterRadius * clusterRadius;
+	TMap<uint32, int32> cellClusters;
+	for (int32 candidateIndex = 0; candidateIndex < candidates.Num(); candidateIndex++)
+	{
+		const int32 anchorIndex = candidates[candidateIndex];
+		const FVector2D point(screenX[anchorIndex], screenY[anchorIndex]);
+		const int32 cellX = FMath::FloorToInt(point.X / cellSize);
+		const int32 cellY = FMath::FloorToInt(point.Y / cellSize);
+
+		int32 nearestCluster = INDEX_NONE;
+		float nearestDistanceSquared = radiusSquared;
+		for (int32 y = cellY - ClusterCellReach; y <= cellY + ClusterCellReach; y++)
+		{
+			for (int32 x = cellX - ClusterCellReach; x <= cellX + ClusterCellReach; x++)
+			{
+				const int32 *cluster = cellClusters.Find(((uint32)(uint16)x << 16) | (uint16)y);
+				if (cluster == NULL)
+				{
+					continue;
+				}
+
+				const float distanceSquared = FVector2D::DistSquared(point, labels[*cluster].position);
+				if (distanceSquared <= nearestDistanceSquared)
+				{
+					nearestCluster = *cluster;
+					nearestDistanceSquared = distanceSquared;
+				}
+			}
+		}
+
+		if (nearestCluster != INDEX_NONE)
+		{
+			labels[nearestCluster].clusterSize++;
+		}
+		else if (labels.Num() < maxLabels)
+		{
+			FLabel &label = labels[labels.AddDefaulted()];
+			label.position = point;
+			label.anchor = anchorIndex;
+			label.clusterSize = 1;
+			cellClusters.Add(((uint32)(uint16)cellX << 16) | (uint16)cellY, labels.Num() - 1);
+		}
+	}
+
+	// Size the labels, centred above their anchors, and fold any that overlap a nearer label into it
+	const float textHeight = font->GetMaxCharHeight();
+	int32 numKept = 0;
+	for (int32 labelIndex = 0; labelIndex < labels.Num(); labelIndex++)
+	{
+		FLabel &label = labels[labelIndex];
+		label.text = label.clusterSize > 1 ? FString::Printf(TEXT("%s (+%d)"), *anchorTexts[label.anchor], label.clusterSize - 1) : anchorTexts[label.anchor];
+		label.size = FVector2D(font->GetStringSize(*label.text) + padding * 2.0f, textHeight + padding * 2.0f);
+		label.position = FVector2D(label.position.X - label.size.X * 0.5f, label.position.Y - label.size.Y);
+
+		int32 overlapped = INDEX_NONE;
+		for (int32 keptIndex = 0; keptIndex < numKept && overlapped == INDEX_NONE; keptIndex++)
+		{
+			const FLabel &kept = labels[keptIndex];
+			if (label.position.X < kept.position.X + kept.size.X && kept.position.X < label.position.X + label.size.X &&
+				label.position.Y < kept.position.Y + kept.size.Y && kept.position.Y < label.position.Y + label.size.Y)
+			{
+				overlapped = keptIndex;
+			}
+		}
+
+		if (overlapped != INDEX_NONE)
+		{
+			FLabel &kept = labels[overlapped];
+			kept.clusterSize += label.clusterSize;
+			kept.text = FString::Printf(TEXT("%s (+%d)"), *anchorTexts[kept.anchor], kept.clusterSize - 1);
+			kept.size.X = font->GetStringSize(*kept.text) + padding * 2.0f;
+		}
+		else
+		{
+			if (numKept != labelIndex)
+			{
+				labels[numKept] = label;
+			}
+			numKept++;
+		}
+	}
+	labels.SetNum(numKept);
+
+	// Two triangles of background behind every label
+	const FLinearColor backgroundColor(0.0f, 0.0f, 0.0f, 0.5f);
+	for (int32 labelIndex = 0; labelIndex < labels.Num(); labelIndex++)
+	{
+		const FVector2D topLeft = labels[labelIndex].position;
+		const FVector2D bottomRight = topLeft + labels[labelIndex].size;
+
+		FCanvasUVTri triangle;
+		triangle.V0_Color = triangle.V1_Color = triangle.V2_Color = backgroundColor;
+		triangle.V0_UV = triangle.V1_UV = triangle.V2_UV = FVector2D::ZeroVector;
+
+		triangle.V0_Pos = topLeft;
+		triangle.V1_Pos = FVector2D(bottomRight.X, topLeft.Y);
+		triangle.V2_Pos = bottomRight;
+		backgroundTriangles.Add(triangle);
+
+		triangle.V1_Pos = bottomRight;
+		triangle.V2_Pos = FVector2D(topLeft.X, bottomRight.Y);
+		backgroundTriangles.Add(triangle);
+	}
+}
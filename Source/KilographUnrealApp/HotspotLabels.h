@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CanvasItem.h"
+
+class UHotspotRegistry;
+
+/**
+ * Labels every registered hotspot that has a label on the HUD. The label anchors are kept in structure of arrays
+ * form and projected four at a time with vector math, labels behind the camera, too far or off
+ * screen are culled, and the rest are clustered on a screen grid so nearby hotspots share one
+ * label with a count. Labels that would still overlap a nearer one are folded into it. The
+ * backgrounds go out as one triangle list and the text in one font, so the canvas batches the
+ * whole layer into two draws. The layout is cached while the camera and hotspots stay put.
+ */
+class KILOGRAPHUNREALAPP_API FHotspotLabels
+{
+public:
+	FHotspotLabels();
+
+	// Lay out the labels for the view, reusing the last layout if nothing moved, and draw them
+	void draw(UCanvas *canvas, UFont *font, UHotspotRegistry *registry, const FVector &viewLocation, const FRotator &viewRotation, float fovDegrees);
+
+	// Screen distance in pixels within which hotspots share a label
+	float clusterRadius;
+
+	// Most labels drawn at once, nearest first
+	int32 maxLabels;
+
+	// Hotspots further than this from the camera are not labelled
+	float maxDistance;
+
+	// Space in pixels between a label's text and the edge of its background
+	float padding;
+
+	// Longest time in seconds a layout is reused, so hotspots shown or hidden meanwhile are picked up
+	float maxCacheAge;
+
+private:
+	struct FLabel
+	{
+		FVector2D position;
+		FVector2D size;
+		int32 anchor;
+		int32 clusterSize;
+		FString text;
+	};
+
+	// Read the anchors and texts of the registered hotspots that have a label
+	void refreshAnchors(UHotspotRegistry *registry);
+
+	// Project every anchor to the screen, four at a time
+	void projectAnchors(const FVector &viewLocation, const FRotator &viewRotation, float fovDegrees, const FVector2D &canvasSize);
+
+	// Cluster and declutter the projected anchors into labels
+	void layoutLabels(const FVector2D &canvasSize, UFont *font);
+
+	/** Anchors of the hotspots, padded to a multiple of four */
+	TArray<float> anchorX;
+	TArray<float> anchorY;
+	TArray<float> anchorZ;
+	TArray<TWeakObjectPtr<class UHotspotComponent> > anchorHotspots;
+	TArray<FString> anchorTexts;
+	int32 numAnchors;
+
+	/** Projection of each anchor, depth along the view and screen position */
+	TArray<float> depths;
+	TArray<float> screenX;
+	TArray<float> screenY;
+
+	TArray<FLabel> labels;
+	TArray<FCanvasUVTri> backgroundTriangles;
+
+	/** View and hotspots the layout was made for */
+	uint32 anchorsVersion;
+	bool hasLayout;
+	FVector layoutLocation;
+	FRotator layoutRotation;
+	float layoutFov;
+	FVector2D layoutCanvasSize;
+	double layoutTime;
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "HotspotRegistry.h"
+#include "HotspotComponent.h"
+#include "KilographUnrealAppGameMode.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hotspot Raycast"), STAT_HotspotRaycast, STATGROUP_Kilograph);
+DECLARE_CYCLE_STAT(TEXT("Hotspot Index Rebuild"), STAT_HotspotRebuild, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Hotspots"), STAT_RegisteredHotspots, STATGROUP_Kilograph);
+
+UHotspotRegistry::UHotspotRegistry()
+{
+	dirty = false;
+	version = 0;
+}
+
+UHotspotRegistry *UHotspotRegistry::get(const UObject *worldContextObject)
+{
+	UWorld *world = worldContextObject != NULL ? worldContextObject->GetWorld() : NULL;
+	if (world == NULL)
+	{
+		return NULL;
+	}
+
+	AKilographUnrealAppGameMode *gameMode = Cast<AKilographUnrealAppGameMode>(world->GetAuthGameMode());
+	return gameMode != NULL ? gameMode->getHotspotRegistry() : NULL;
+}
+
+void UHotspotRegistry::registerHotspot(UHotspotComponent *hotspot)
+{
+	if (hotspot != NULL && !hotspots.Contains(hotspot))
+	{
+		hotspots.Add(hotspot);
+		INC_DWORD_STAT(STAT_RegisteredHotspots);
+		dirty = true;
+		version++;
+	}
+}
+
+void UHotspotRegistry::unregisterHotspot(UHotspotComponent *hotspot)
+{
+	if (hotspots.RemoveSingleSwap(hotspot) > 0)
+	{
+		DEC_DWORD_STAT(STAT_RegisteredHotspots);
+		dirty = true;
+		version++;
+	}
+}
+
+void UHotspotRegistry::markDirty()
+{
+	dirty = true;
+	version++;
+}
+
+UHotspotComponent *UHotspotRegistry::raycast(const FVector &origin, const FVector &direction, float maxDistance, float &outDistance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HotspotRaycast);
+
+	if (dirty)
+	{
+		rebuild();
+	}
+
+	const int32 hotspotIndex = hierarchy.raycast(origin, direction, maxDistance, outDistance);
+	return hotspotIndex != INDEX_NONE ? hotspots[hotspotIndex] : NULL;
+}
+
+void UHotspotRegistry::rebuild()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HotspotRebuild);
+
+	dirty = false;
+
+	// Destroyed hotspots are nulled out by garbage collection
+	const int32 numDestroyed = hotspots.Remove(nullptr);
+	DEC_DWORD_STAT_BY(STAT_RegisteredHotspots, numDestroyed);
+
+	TArray<FBox> bounds;
+	bounds.Reserve(hotspots.Num());
+	for (int32 hotspotIndex = 0; hotspotIndex < hotspots.Num(); hotspotIndex++)
+	{
+		bounds.Add(hotspots[hotspotIndex]->getBounds());
+	}
+	hierarchy.build(bounds);
+}
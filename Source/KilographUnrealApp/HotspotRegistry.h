@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BoundsHierarchy.h"
+#include "HotspotRegistry.generated.h"
+
+class UHotspotComponent;
+
+/**
+ * World level registry of every hotspot in play. The hotspot bounds are kept in a bounding
+ * volume hierarchy that is rebuilt lazily when hotspots come and go, so resolving a tap is a
+ * ray query whose cost grows with the log of the hotspot count.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UHotspotRegistry : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UHotspotRegistry();
+
+	// Find the registry of the world the given object lives in
+	static UHotspotRegistry *get(const UObject *worldContextObject);
+
+	// Add a hotspot to the index
+	void registerHotspot(UHotspotComponent *hotspot);
+
+	// Remove a hotspot from the index
+	void unregisterHotspot(UHotspotComponent *hotspot);
+
+	// Rebuild the index before the next query, used when hotspots have moved
+	void markDirty();
+
+	/**
+	* Find the closest hotspot whose bounds are hit by a ray
+	* @param	origin		Start of the ray
+	* @param	direction	Unit direction of the ray
+	* @param	maxDistance	Length of the ray
+	* @param	outDistance	Distance along the ray at which the hotspot's bounds are entered
+	* @returns the hotspot hit, NULL if there is none
+	*/
+	UHotspotComponent *raycast(const FVector &origin, const FVector &direction, float maxDistance, float &outDistance);
+
+	// Number of hotspots currently registered
+	int32 getNumHotspots() const { return hotspots.Num(); }
+
+	// Registered hotspots, may hold NULL entries for destroyed hotspots until the next rebuild
+	const TArray<UHotspotComponent *> &getHotspots() const { return hotspots; }
+
+	// Bumped whenever hotspots are added, removed or moved, so caches of their layout know to refresh
+	uint32 getVersion() const { return version; }
+
+private:
+	// Rebuild the hierarchy from the registered hotspots
+	void rebuild();
+
+	/** Registered hotspots */
+	UPROPERTY()
+	TArray<UHotspotComponent *> hotspots;
+
+	/** Hierarchy over the hotspot bounds, items are indices into hotspots */
+	FBoundsHierarchy hierarchy;
+
+	bool dirty;
+	uint32 version;
+};
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "InputRecording.h"
+#include "Json.h"
+
+// Identifies recording files and their layout
+static const uint32 RecordingMagic = 0x4345524B; // 'KREC'
+static const uint32 RecordingVersion = 1;
+
+FArchive &operator<<(FArchive &Ar, FInputRecordEvent &event)
+{
+	uint8 type = (uint8)event.type;
+	Ar << event.time;
+	Ar << type;
+	Ar << event.fingerIndex;
+	Ar << event.location;
+	event.type = (EInputRecordType)type;
+	return Ar;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/////////////////////////     RECORDER     ///////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+FInputRecorder::FInputRecorder()
+	: time(0.0f)
+	, recording(false)
+{
+}
+
+void FInputRecorder::start()
+{
+	events.Reset();
+	time = 0.0f;
+	recording = true;
+}
+
+void FInputRecorder::advance(float DeltaSeconds)
+{
+	time += DeltaSeconds;
+}
+
+void FInputRecorder::record(EInputRecordType type, uint8 fingerIndex, const FVector &location)
+{
+	if (!recording)
+	{
+		return;
+	}
+
+	FInputRecordEvent event;
+	event.time = time;
+	event.type = type;
+	event.fingerIndex = fingerIndex;
+	event.location = FVector2D(location.X, location.Y);
+	events.Add(event);
+}
+
+bool FInputRecorder::save(const FString &path)
+{
+	recording = false;
+
+	TArray<uint8> data;
+	FMemoryWriter writer(data);
+	uint32 magic = RecordingMagic;
+	uint32 version = RecordingVersion;
+	writer << magic;
+	writer << version;
+	writer << events;
+
+	if (!FFileHelper::SaveArrayToFile(data, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to save input recording to %s"), *path);
+		return false;
+	}
+
+	UE_LOG(Kilograph, Log, TEXT("Saved %d recorded inputs to %s"), events.Num(), *path);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/////////////////////////     REPLAYER     ///////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+FInputReplayer::FInputReplayer()
+	: nextEvent(0)
+	, time(0.0f)
+	, replaying(false)
+{
+}
+
+bool FInputReplayer::load(const FString &path)
+{
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to read input recording %s"), *path);
+		return false;
+	}
+
+	FMemoryReader reader(data);
+	uint32 magic = 0;
+	uint32 version = 0;
+	reader << magic;
+	reader << version;
+	if (magic != RecordingMagic || version != RecordingVersion)
+	{
+		UE_LOG(Kilograph, Error, TEXT("%s is not a supported input recording"), *path);
+		return false;
+	}
+	reader << events;
+
+	nextEvent = 0;
+	time = 0.0f;
+	replaying = true;
+	return true;
+}
+
+void FInputReplayer::advance(float DeltaSeconds, TArray<FInputRecordEvent> &outEvents)
+{
+	outEvents.Reset();
+	if (!replaying)
+	{
+		return;
+	}
+
+	time += DeltaSeconds;
+	while (nextEvent < events.Num() && events[nextEvent].time <= time)
+	{
+		outEvents.Add(events[nextEvent++]);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+/////////////////////////     BENCHMARK    ///////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+void FReplayBenchmark::addFrame(const TCHAR *stateName, float gameThreadMs, uint32 allocations)
+{
+	FStateTotals &totals = states.FindOrAdd(stateName);
+	totals.frames++;
+	totals.gameThreadMs += gameThreadMs;
+	totals.maxGameThreadMs = FMath::Max(totals.maxGameThreadMs, gameThreadMs);
+	totals.allocations += allocations;
+}
+
+bool FReplayBenchmark::writeReport(const FString &path) const
+{
+	FString output;
+	TSharedRef<TJsonWriter<> > writer = TJsonWriterFactory<>::Create(&output);
+
+	writer->WriteObjectStart();
+	writer->WriteObjectStart(TEXT("states"));
+	for (TMap<FString, FStateTotals>::TConstIterator stateIt(states); stateIt; ++stateIt)
+	{
+		const FStateTotals &totals = stateIt.Value();
+		writer->WriteObjectStart(stateIt.Key());
+		writer->WriteValue(TEXT("frames"), (int32)totals.frames);
+		writer->WriteValue(TEXT("gameThreadMsTotal"), totals.gameThreadMs);
+		writer->WriteValue(TEXT("gameThreadMsAverage"), totals.frames > 0 ? totals.gameThreadMs / totals.frames : 0.0);
+		writer->WriteValue(TEXT("gameThreadMsMax"), totals.maxGameThreadMs);
+		writer->WriteValue(TEXT("allocations"), (double)totals.allocations);
+		writer->WriteValue(TEXT("allocationsPerFrame"), totals.frames > 0 ? (double)totals.allocations / totals.frames : 0.0);
+		writer->WriteObjectEnd();
+	}
+	writer->WriteObjectEnd();
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to write replay benchmark to %s"), *path);
+		return false;
+	}
+
+	UE_LOG(Kilograph, Log, TEXT("Wrote replay benchmark to %s"), *path);
+	return true;
+}
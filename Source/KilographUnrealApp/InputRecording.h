@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/** Kinds of input captured by the recorder */
+enum class EInputRecordType : uint8
+{
+	BeginTouch,
+	EndTouch,
+	TouchUpdate,
+	SkyboxView,
+	CameraFollow,
+	OverviewMode,
+	FreeRun
+};
+
+/** A single recorded input, touch events carry their finger and screen location */
+struct FInputRecordEvent
+{
+	float time;
+	EInputRecordType type;
+	uint8 fingerIndex;
+	FVector2D location;
+
+	friend FArchive &operator<<(FArchive &Ar, FInputRecordEvent &event);
+};
+
+/**
+ * Captures the touch stream and mode button callbacks of a session with their timestamps so
+ * they can be saved to a compact binary file and replayed later.
+ */
+class KILOGRAPHUNREALAPP_API FInputRecorder
+{
+public:
+	FInputRecorder();
+
+	// Start capturing, dropping anything recorded before
+	void start();
+
+	// Whether input is currently being captured
+	bool isRecording() const { return recording; }
+
+	// Advance the recording clock
+	void advance(float DeltaSeconds);
+
+	// Capture an input at the current time
+	void record(EInputRecordType type, uint8 fingerIndex = 0, const FVector &location = FVector::ZeroVector);
+
+	// Stop capturing and write the recording to disk
+	bool save(const FString &path);
+
+private:
+	TArray<FInputRecordEvent> events;
+	float time;
+	bool recording;
+};
+
+/**
+ * Plays a recording back, handing out the inputs that are due as the replay clock advances.
+ */
+class KILOGRAPHUNREALAPP_API FInputReplayer
+{
+public:
+	FInputReplayer();
+
+	// Read a recording from disk and start replaying it
+	bool load(const FString &path);
+
+	// Whether a recording is being replayed
+	bool isReplaying() const { return replaying; }
+
+	// Whether every input of the recording has been handed out
+	bool isFinished() const { return replaying && nextEvent >= events.Num(); }
+
+	// Advance the replay clock and gather the inputs that are now due
+	void advance(float DeltaSeconds, TArray<FInputRecordEvent> &outEvents);
+
+private:
+	TArray<FInputRecordEvent> events;
+	int32 nextEvent;
+	float time;
+	bool replaying;
+};
+
+/**
+ * Accumulates per-state frame costs during a replay and writes them out as JSON.
+ */
+class KILOGRAPHUNREALAPP_API FReplayBenchmark
+{
+public:
+	// Record the cost of a frame spent in the given state
+	void addFrame(const TCHAR *stateName, float gameThreadMs, uint32 allocations);
+
+	// Write the accumulated totals to a JSON file
+	bool writeReport(const FString &path) const;
+
+private:
+	struct FStateTotals
+	{
+		FStateTotals() : frames(0), gameThreadMs(0.0), maxGameThreadMs(0.0f), allocations(0) {}
+
+		uint32 frames;
+		double gameThreadMs;
+		float maxGameThreadMs;
+		uint64 allocations;
+	};
+
+	TMap<FString, FStateTotals> states;
+};
@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "InstanceMerger.h"
+#include "PrecomputedVisibility.h"
+#include "OrbitProxy.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "EngineUtils.h"
+
+DECLARE_CYCLE_STAT(TEXT("Instance Merge"), STAT_InstanceMerge, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Merged Mesh Components"), STAT_MergedMeshComponents, STATGROUP_Kilograph);
+
+// Sets default values for this component's properties
+UInstanceMerger::UInstanceMerger()
+{
+	// Only works when play begins, never ticks
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = false;
+
+	minInstances = 2;
+	mergeOnBeginPlay = true;
+}
+
+// Called when the game starts
+void UInstanceMerger::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (mergeOnBeginPlay)
+	{
+		const int32 merged = mergeChildren();
+		UE_LOG(Kilograph, Log, TEXT("Merged %d mesh components under %s into %d instanced components"), merged, *GetOwner()->GetName(), instancedComponents.Num());
+	}
+}
+
+int32 UInstanceMerger::mergeChildren()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InstanceMerge);
+
+	USceneComponent *root = GetOwner()->GetRootComponent();
+	if (root == NULL)
+	{
+		return 0;
+	}
+
+	// The players' culling hides actors one by one, an instance merged out of its actor would stay drawn
+	TArray<UPrecomputedVisibility *> visibilities;
+	TArray<UOrbitProxy *> orbitProxies;
+	for (TActorIterator<APawn> pawnIt(GetWorld()); pawnIt; ++pawnIt)
+	{
+		UPrecomputedVisibility *visibility = pawnIt->FindComponentByClass<UPrecomputedVisibility>();
+		if (visibility != NULL)
+		{
+			visibilities.Add(visibility);
+		}
+		UOrbitProxy *orbitProxy = pawnIt->FindComponentByClass<UOrbitProxy>();
+		if (orbitProxy != NULL)
+		{
+			orbitProxies.Add(orbitProxy);
+		}
+	}
+
+	TArray<USceneComponent*> childrenRoots;
+	root->GetChildrenComponents(true, childrenRoots);
+
+	TArray<FMergeGroup> groups;
+	TMap<AActor *, bool> culledActors;
+	for (int32 childIndex = 0; childIndex < childrenRoots.Num(); childIndex++)
+	{
+		UStaticMeshComponent *component = Cast<UStaticMeshComponent>(childrenRoots[childIndex]);
+		if (component == NULL || !canMerge(component))
+		{
+			continue;
+		}
+
+		// Actors often hold several meshes, each is only looked up once
+		AActor *actor = component->GetOwner();
+		bool *knownCulled = culledActors.Find(actor);
+		bool culled = knownCulled != NULL && *knownCulled;
+		for (int32 index = 0; knownCulled == NULL && !culled && index < visibilities.Num(); index++)
+		{
+			culled = visibilities[index]->coversActor(actor);
+		}
+		for (int32 index = 0; knownCulled == NULL && !culled && index < orbitProxies.Num(); index++)
+		{
+			culled = orbitProxies[index]->coversActor(actor);
+		}
+		culledActors.Add(actor, culled);
+
+		if (!culled)
+		{
+			addToGroup(groups, component);
+		}
+	}
+
+	int32 merged = 0;
+	for (int32 groupIndex = 0; groupIndex < groups.Num(); groupIndex++)
+	{
+		if (groups[groupIndex].components.Num() >= minInstances)
+		{
+			mergeGroup(groups[groupIndex]);
+			merged += groups[groupIndex].components.Num();
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_MergedMeshComponents, merged);
+	return merged;
+}
+
+bool UInstanceMerger::canMerge(const UStaticMeshComponent *component) const
+{
+	// Moving or already instanced meshes, and meshes the owner or the scene hides, keep their own component
+	const AActor *actor = component->GetOwner();
+	return component->StaticMesh != NULL &&
+		component->Mobility == EComponentMobility::Static &&
+		!component->IsA<UInstancedStaticMeshComponent>() &&
+		!hasStaticLighting(component) &&
+		component->IsRegistered() &&
+		component->IsVisible() &&
+		actor != GetOwner() &&
+		!actor->bHidden;
+}
+
+bool UInstanceMerger::hasStaticLighting(const UStaticMeshComponent *component)
+{
+	// Instances created at runtime have no lightmaps, so meshes lit by a build would lose their baked lighting
+	for (int32 lodIndex = 0; lodIndex < component->LODData.Num(); lodIndex++)
+	{
+		const FStaticMeshComponentLODInfo &lodInfo = component->LODData[lodIndex];
+		if (lodInfo.LightMap.IsValid() || lodInfo.ShadowMap.IsValid())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UInstanceMerger::sharesSettings(const UStaticMeshComponent *component, const UStaticMeshComponent *other)
+{
+	// Everything the instanced component takes from the group's first component has to match across the group
+	if (component->Mobility != other->Mobility ||
+		component->bHiddenInGame != other->bHiddenInGame ||
+		component->bVisible != other->bVisible ||
+		component->CastShadow != other->CastShadow ||
+		component->bCastDynamicShadow != other->bCastDynamicShadow ||
+		component->bCastStaticShadow != other->bCastStaticShadow ||
+		component->GetCollisionProfileName() != other->GetCollisionProfileName())
+	{
+		return false;
+	}
+
+	// Custom collision is only named as such, its settings are compared instead
+	return component->GetCollisionProfileName() != UCollisionProfile::CustomCollisionProfileName ||
+		(component->GetCollisionEnabled() == other->GetCollisionEnabled() &&
+		component->GetCollisionObjectType() == other->GetCollisionObjectType() &&
+		FMemory::Memcmp(&component->GetCollisionResponseToChannels(), &other->GetCollisionResponseToChannels(), sizeof(FCollisionResponseContainer)) == 0);
+}
+
+void UInstanceMerger::addToGroup(TArray<FMergeGroup> &groups, UStaticMeshComponent *component)
+{
+	TArray<UMaterialInterface *> materials;
+	for (int32 materialIndex = 0; materialIndex < component->GetNumMaterials(); materialIndex++)
+	{
+		materials.Add(component->GetMaterial(materialIndex));
+	}
+
+	// Scenes only repeat a handful of meshes, a linear search is enough
+	for (int32 groupIndex = 0; groupIndex < groups.Num(); groupIndex++)
+	{
+		FMergeGroup &group = groups[groupIndex];
+		if (group.mesh == component->StaticMesh && group.materials == materials && sharesSettings(component, group.components[0]))
+		{
+			group.components.Add(component);
+			return;
+		}
+	}
+
+	FMergeGroup &group = groups[groups.AddDefaulted()];
+	group.mesh = component->StaticMesh;
+	group.materials = materials;
+	group.components.Add(component);
+}
+
+void UInstanceMerger::mergeGroup(const FMergeGroup &group)
+{
+	USceneComponent *root = GetOwner()->GetRootComponent();
+	const UStaticMeshComponent *first = group.components[0];
+
+	UHierarchicalInstancedStaticMeshComponent *instanced = NewObject<UHierarchicalInstancedStaticMeshComponent>(GetOwner());
+	instanced->SetMobility(root->Mobility);
+	instanced->SetStaticMesh(group.mesh);
+	for (int32 materialIndex = 0; materialIndex < group.materials.Num(); materialIndex++)
+	{
+		instanced->SetMaterial(materialIndex, group.materials[materialIndex]);
+	}
+	instanced->SetHiddenInGame(first->bHiddenInGame);
+	instanced->SetVisibility(first->bVisible);
+	instanced->CastShadow = first->CastShadow;
+	instanced->bCastDynamicShadow = first->bCastDynamicShadow;
+	instanced->bCastStaticShadow = first->bCastStaticShadow;
+	if (first->GetCollisionProfileName() == UCollisionProfile::CustomCollisionProfileName)
+	{
+		instanced->SetCollisionEnabled(first->GetCollisionEnabled());
+		instanced->SetCollisionObjectType(first->GetCollisionObjectType());
+		instanced->SetCollisionResponseToChannels(first->GetCollisionResponseToChannels());
+	}
+	else
+	{
+		instanced->SetCollisionProfileName(first->GetCollisionProfileName());
+	}
+	instanced->AttachTo(root);
+
+	// Instances are relative to the owner's root, the merged actors keep their transforms and attachment
+	const FTransform rootTransform = root->GetComponentTransform();
+	for (int32 componentIndex = 0; componentIndex < group.components.Num(); componentIndex++)
+	{
+		UStaticMeshComponent *component = group.components[componentIndex];
+		instanced->AddInstance(component->GetComponentTransform().GetRelativeTransform(rootTransform));
+		component->UnregisterComponent();
+	}
+
+	// Registering once all instances are in builds the cluster tree a single time
+	instanced->RegisterComponent();
+	instancedComponents.Add(instanced);
+}
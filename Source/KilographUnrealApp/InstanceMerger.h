@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "InstanceMerger.generated.h"
+
+/**
+ * Folds the repeated static meshes of the actors attached below its owner, such as the path
+ * markers or the skybox pieces, into one hierarchical instanced component per mesh and material
+ * set when play begins. The merged actors stay in place so anything reading their locations or
+ * order is unaffected, only their mesh components are unregistered. The instanced components
+ * belong to the owner, so hiding the owner's attachment tree hides them along with the rest.
+ * Meshes with built static lighting are left alone, their instances would be drawn unlit, and so
+ * are the actors a player's precomputed visibility or orbit proxy hides one by one.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UInstanceMerger : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UInstanceMerger();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Merge the meshes below the owner, returns the number of mesh components folded into instances
+	int32 mergeChildren();
+
+	// Fewest copies of a mesh worth instancing, rarer meshes are left as they are
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Instancing)
+	int32 minInstances;
+
+	// Whether the merge happens when play begins
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Instancing)
+	bool mergeOnBeginPlay;
+
+private:
+	// Static mesh components below the owner sharing a mesh, materials and the settings the instances take on
+	struct FMergeGroup
+	{
+		class UStaticMesh *mesh;
+		TArray<class UMaterialInterface *> materials;
+		TArray<class UStaticMeshComponent *> components;
+	};
+
+	// Whether a component can be drawn as an instance without changing how it looks or collides
+	bool canMerge(const class UStaticMeshComponent *component) const;
+
+	// Whether a lighting build left the component lightmaps or shadowmaps, which instancing would drop
+	static bool hasStaticLighting(const class UStaticMeshComponent *component);
+
+	// Whether two components cast shadows, collide, move and show alike, so one instanced component can stand in for both
+	static bool sharesSettings(const class UStaticMeshComponent *component, const class UStaticMeshComponent *other);
+
+	// Add a component to the group matching its mesh, materials and settings
+	static void addToGroup(TArray<FMergeGroup> &groups, class UStaticMeshComponent *component);
+
+	// Replace a group's components with one instanced component on the owner
+	void mergeGroup(const FMergeGroup &group);
+
+	/** Instanced components created by the merge */
+	UPROPERTY()
+	TArray<class UHierarchicalInstancedStaticMeshComponent *> instancedComponents;
+};
@@ -7,5 +7,7 @@ public class KilographUnrealApp : ModuleRules
 	public KilographUnrealApp(TargetInfo Target)
 	{
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "RenderCore", "RHI" });
 	}
 }
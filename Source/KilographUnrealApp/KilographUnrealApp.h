@@ -8,4 +8,10 @@
 //General Log
 DECLARE_LOG_CATEGORY_EXTERN(Kilograph, Log, All);
 
+//Stats shown with "stat Kilograph"
+DECLARE_STATS_GROUP(TEXT("Kilograph"), STATGROUP_Kilograph, STATCAT_Advanced);
+
+//Per mode costs shown with "stat KilographModes"
+DECLARE_STATS_GROUP(TEXT("KilographModes"), STATGROUP_KilographModes, STATCAT_Advanced);
+
 #endif
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "KilographUnrealAppCameraManager.h"
+#include "OrbitCamera.h"
+
+void AKilographUnrealAppCameraManager::UpdateViewTarget(FTViewTarget &OutVT, float DeltaTime)
+{
+	UOrbitCamera *orbitCamera = OutVT.Target != NULL ? OutVT.Target->FindComponentByClass<UOrbitCamera>() : NULL;
+	if (orbitCamera == NULL || !orbitCamera->isOrbiting())
+	{
+		Super::UpdateViewTarget(OutVT, DeltaTime);
+		return;
+	}
+
+	OutVT.POV.Location = orbitCamera->getCameraLocation();
+	OutVT.POV.Rotation = orbitCamera->getCameraRotation();
+	OutVT.POV.FOV = DefaultFOV;
+	OutVT.POV.OrthoWidth = DefaultOrthoWidth;
+	OutVT.POV.ProjectionMode = ECameraProjectionMode::Perspective;
+	OutVT.POV.PostProcessBlendWeight = 0.0f;
+
+	ApplyCameraModifiers(DeltaTime, OutVT.POV);
+}
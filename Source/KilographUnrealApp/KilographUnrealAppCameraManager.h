@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Camera/PlayerCameraManager.h"
+#include "KilographUnrealAppCameraManager.generated.h"
+
+/**
+ * Camera manager that takes the view from the view target's orbit camera while it is orbiting,
+ * so orbiting moves only the view and never the character.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API AKilographUnrealAppCameraManager : public APlayerCameraManager
+{
+	GENERATED_BODY()
+
+protected:
+	// Use the orbit's view when the view target is orbiting, the view target's own camera otherwise
+	virtual void UpdateViewTarget(FTViewTarget &OutVT, float DeltaTime) override;
+};
@@ -2,12 +2,32 @@
 
 #include "KilographUnrealApp.h"
 #include "KilographUnrealAppCharacter.h"
+#include "HotspotComponent.h"
+#include "HotspotRegistry.h"
+#include "VisibilityGroups.h"
+#include "PrecomputedVisibility.h"
+#include "OrbitCamera.h"
+#include "OrbitProxy.h"
+#include "PanoramaViewer.h"
+#include "QualityGovernor.h"
+#include "ZoneStreamer.h"
+#include "KinematicWalker.h"
+#include "KilographUnrealAppProjectile.h"
+#include "ProjectilePool.h"
 #include "Animation/AnimInstance.h"
 #include "GameFramework/InputSettings.h"
 #include "Runtime/Engine/Classes/Kismet/KismetMathLibrary.h"
+#include "RenderCore.h"
+
+DECLARE_CYCLE_STAT(TEXT("Orbit Reposition"), STAT_OrbitReposition, STATGROUP_Kilograph);
+DECLARE_CYCLE_STAT(TEXT("Trace For Hotspots"), STAT_TraceForHotspots, STATGROUP_Kilograph);
+DECLARE_CYCLE_STAT(TEXT("Hide Skybox"), STAT_HideSkybox, STATGROUP_Kilograph);
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
+// Visibility group made of the actors under skyboxCenter
+static const FName SkyboxGroup(TEXT("Skybox"));
+
 //////////////////////////////////////////////////////////////////////////
 ///////////////////////  CONSTRUCTOR  ////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -26,11 +46,55 @@ AKilographUnrealAppCharacter::AKilographUnrealAppCharacter()
 	FirstPersonCameraComponent->RelativeLocation = FVector(0, 0, 64.f); // Position the camera
 	FirstPersonCameraComponent->bUsePawnControlRotation = true;
 
+	// Create the visibility groups used to switch between modes
+	VisibilityGroups = CreateDefaultSubobject<UVisibilityGroups>(TEXT("VisibilityGroups"));
+
+	// Create the baked culling used along the tour and the orbit
+	PrecomputedVisibility = CreateDefaultSubobject<UPrecomputedVisibility>(TEXT("PrecomputedVisibility"));
+
+	// Create the transition used to switch states without a hitch, the panorama needs the skybox ready
+	ModeTransition = CreateDefaultSubobject<UModeTransition>(TEXT("ModeTransition"));
+	ModeTransition->onCommit.BindUObject(this, &AKilographUnrealAppCharacter::commitState);
+	panoramaResources.visibilityGroups.Add(SkyboxGroup);
+
+	// Create the orbit view
+	OrbitCamera = CreateDefaultSubobject<UOrbitCamera>(TEXT("OrbitCamera"));
+
+	// Create the detail swap used while orbiting
+	OrbitProxy = CreateDefaultSubobject<UOrbitProxy>(TEXT("OrbitProxy"));
+
+	// Create the governor keeping each state at its frame time
+	QualityGovernor = CreateDefaultSubobject<UQualityGovernor>(TEXT("QualityGovernor"));
+
+	// Create the zone streaming used while walking and touring
+	ZoneStreamer = CreateDefaultSubobject<UZoneStreamer>(TEXT("ZoneStreamer"));
+
+	// Create the lightweight walk, used instead of the character movement when enabled
+	KinematicWalker = CreateDefaultSubobject<UKinematicWalker>(TEXT("KinematicWalker"));
+
 	// Default offset from the character location for projectiles to spawn
 	GunOffset = FVector(100.0f, 30.0f, 10.0f);
+	projectilePoolSize = 16;
 
 	// Initialize state to freerun
 	state = FREERUN;
+	pendingState = FREERUN;
+
+	panoramaViewer = NULL;
+	currentPanorama = 0;
+	walkLocation = FVector::ZeroVector;
+	walkRotation = FRotator::ZeroRotator;
+
+	// Follow orbit drags immediately unless smoothing is configured
+	orbitSmoothingTime = 0.0f;
+
+	// Range the orbit can be pinched through
+	minRotationDistance = 100.0f;
+	maxRotationDistance = 20000.0f;
+	bakedRotationDistance = 0.0f;
+	pendingDrag = FVector2D::ZeroVector;
+	nextHotspotTraceId = 0;
+	hotspotTraceDelegate.BindUObject(this, &AKilographUnrealAppCharacter::onHotspotTraceDone);
 
 	// Note: The ProjectileClass and the skeletal mesh/anim blueprints for Mesh1P are set in the
 	// derived blueprint asset named MyCharacter (to avoid direct content references in C++)
@@ -48,11 +112,32 @@ void AKilographUnrealAppCharacter::SetupPlayerInputComponent(class UInputCompone
 		cameraFollow->setPlayer(this);
 	}
 
-	// Start the player at the correct orbiting position
+	// Spawn the projectiles ahead of time so firing doesn't spawn actors
+	UProjectilePool *projectilePool = UProjectilePool::get(this);
+	if (ProjectileClass != NULL && projectilePool != NULL)
+	{
+		projectilePool->prewarm(ProjectileClass, projectilePoolSize);
+	}
+
+	// Group the skybox actors so mode switches don't walk the hierarchy again
+	if (skyboxCenter != NULL)
+	{
+		VisibilityGroups->addGroup(SkyboxGroup, skyboxCenter);
+	}
+
+	// The visibility bake places its orbit views at the distance set on the character, before any pinch
+	bakedRotationDistance = rotationDistance;
+
+	// Start the player at the correct orbiting position, or walking where it spawned when there is nothing to orbit
 	if (rotationObject != NULL)
 	{
 		activateOverviewMode();
 	}
+	else
+	{
+		QualityGovernor->setState(getStateName(state));
+		commitState();
+	}
 
 	// set up gameplay key bindings
 	check(InputComponent);
@@ -76,6 +161,25 @@ void AKilographUnrealAppCharacter::SetupPlayerInputComponent(class UInputCompone
 	InputComponent->BindAxis("TurnRate", this, &AKilographUnrealAppCharacter::TurnAtRate);
 	InputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
 	InputComponent->BindAxis("LookUpRate", this, &AKilographUnrealAppCharacter::LookUpAtRate);
+
+	startInputCapture();
+}
+
+void AKilographUnrealAppCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (inputRecorder.isRecording())
+	{
+		inputRecorder.save(recordingPath);
+	}
+
+	// -KiloModeStats=<file> keeps the per state frame costs of the session
+	FString modeStatsPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("KiloModeStats="), modeStatsPath))
+	{
+		modeProfiler.writeCsv(modeStatsPath);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -83,157 +187,240 @@ void AKilographUnrealAppCharacter::SetupPlayerInputComponent(class UInputCompone
 //////////////////////////////////////////////////////////////////////////
 void AKilographUnrealAppCharacter::BeginTouch(const ETouchIndex::Type FingerIndex, const FVector Location)
 {
-	if (TouchItem.bIsPressed == true)
-	{
-		return;
-	}
-	TouchItem.bIsPressed = true;
-	TouchItem.FingerIndex = FingerIndex;
-	TouchItem.Location = Location;
-	TouchItem.bMoved = false;
+	inputRecorder.record(EInputRecordType::BeginTouch, FingerIndex, Location);
+
+	// Touches are only queued here, Tick classifies them once per frame
+	touchGestures.beginTouch(FingerIndex, Location);
 }
 
 void AKilographUnrealAppCharacter::EndTouch(const ETouchIndex::Type FingerIndex, const FVector Location)
 {
-	if (TouchItem.bIsPressed == false)
+	inputRecorder.record(EInputRecordType::EndTouch, FingerIndex, Location);
+
+	touchGestures.endTouch(FingerIndex, Location);
+}
+
+void AKilographUnrealAppCharacter::TouchUpdate(const ETouchIndex::Type FingerIndex, const FVector Location)
+{
+	inputRecorder.record(EInputRecordType::TouchUpdate, FingerIndex, Location);
+
+	touchGestures.moveTouch(FingerIndex, Location);
+}
+
+//////////////////////////////////////////////////////////////////////////
+////////////////////  STATE TOUCH FUNCTIONS  /////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+void AKilographUnrealAppCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (inputRecorder.isRecording())
 	{
-		return;
+		inputRecorder.advance(DeltaSeconds);
 	}
-	if ((FingerIndex == TouchItem.FingerIndex) && (TouchItem.bMoved == false))
+	else if (inputReplayer.isReplaying())
+	{
+		replayInput(DeltaSeconds);
+	}
+
+	// The frame that just finished ran in the state the player is still in, or the one it left this tick
+	modeProfiler.sampleFrame(ModeTransition->isTransitioning() ? TEXT("TRANSITION") : getStateName(state), DeltaSeconds);
+
+	// Classify the touches of the frame, taps fire and check for hotspots, drags accumulate with the other drag input
+	FVector2D viewportSize = FVector2D::ZeroVector;
+	if (GetWorld()->GetGameViewport() != NULL)
+	{
+		GetWorld()->GetGameViewport()->GetViewportSize(viewportSize);
+	}
+	touchGestures.update(DeltaSeconds, viewportSize, frameGestures);
+	for (int32 tapIndex = 0; tapIndex < frameGestures.taps.Num(); tapIndex++)
 	{
 		OnFire();
+		pendingTaps.Add(frameGestures.taps[tapIndex]);
 	}
-	TouchItem.bIsPressed = false;
+	pendingDrag += frameGestures.drag * BaseTurnRate;
 
-	// Now check to see if the user has clicked on a hotspot, activate them if so
-	traceForHotspots();
-}
+	if (pendingTaps.Num() > 0)
+	{
+		traceForHotspots(pendingTaps);
+		pendingTaps.Reset();
+	}
 
-void AKilographUnrealAppCharacter::TouchUpdate(const ETouchIndex::Type FingerIndex, const FVector Location)
-{
-	if ((TouchItem.bIsPressed == true) && (TouchItem.FingerIndex == FingerIndex))
+	// The transition owns the view until the new state commits
+	if (ModeTransition->isTransitioning())
 	{
-		if (!TouchItem.bIsPressed)
-		{
-			return;
-		}
+		pendingDrag = FVector2D::ZeroVector;
+		return;
+	}
 
-		if (GetWorld() == nullptr)
-		{
-			return;
-		}
+	if (!pendingDrag.IsZero())
+	{
+		applyDrag(pendingDrag.X, pendingDrag.Y);
+		pendingDrag = FVector2D::ZeroVector;
+	}
 
-		UGameViewportClient* ViewportClient = GetWorld()->GetGameViewport();
-		if (ViewportClient != nullptr)
-		{
-			FVector MoveDelta = Location - TouchItem.Location;
-			FVector2D ScreenSize;
-			ViewportClient->GetViewportSize(ScreenSize);
-			FVector2D ScaledDelta = FVector2D(MoveDelta.X, MoveDelta.Y) / ScreenSize;
-			if (ScaledDelta.X != 0.0f)
-			{
-				TouchItem.bMoved = true;
-				float Value = ScaledDelta.X * BaseTurnRate;
-				tapDragX(Value);
-			}
-			if (ScaledDelta.Y != 0.0f)
-			{
-				TouchItem.bMoved = true;
-				float Value = ScaledDelta.Y* BaseTurnRate;
-				tapDragY(Value);
-			}
-			TouchItem.Location = Location;
-		}
-		TouchItem.Location = Location;
+	if (frameGestures.pinchScale != 1.0f || frameGestures.rotation != 0.0f)
+	{
+		applyPinchRotate(frameGestures.pinchScale, frameGestures.rotation);
+	}
+
+	if (state == ORBIT && smoothOrbit(DeltaSeconds))
+	{
+		orbitReposition();
+	}
+	else if (state == TOUR && cameraFollow != NULL)
+	{
+		PrecomputedVisibility->updateTour(cameraFollow->getTourName(), cameraFollow->getDistanceAlongPath());
 	}
 }
 
-//////////////////////////////////////////////////////////////////////////
-////////////////////  STATE TOUCH FUNCTIONS  /////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-void AKilographUnrealAppCharacter::tapDragX(float Value)
+void AKilographUnrealAppCharacter::applyDrag(float deltaX, float deltaY)
 {
 	switch (state)
 	{
 	case FREERUN:
-	{
-		AddControllerYawInput(Value);
-		break;
-	}
+	case TOUR:
 	case PANORAMA:
 	{
-		AddControllerYawInput(Value);
+		AddControllerYawInput(deltaX);
+		AddControllerPitchInput(deltaY);
 		break;
 	}
 	case ORBIT:
 	{
-		currentZRotationAroundObject += Value;
-		orbitReposition();
+		targetZRotationAroundObject += deltaX;
+		// Clamp the x rotation around the max values
+		targetXRotationAroundObject = FMath::Clamp(targetXRotationAroundObject - deltaY, minRotationX, maxRotationX);
+
+		// Without smoothing the orbit jumps straight to the target, otherwise Tick eases towards it
+		if (orbitSmoothingTime <= 0.0f)
+		{
+			currentXRotationAroundObject = targetXRotationAroundObject;
+			currentZRotationAroundObject = targetZRotationAroundObject;
+			orbitReposition();
+		}
 		break;
 	}
 	}
 }
 
-void AKilographUnrealAppCharacter::tapDragY(float Value)
+void AKilographUnrealAppCharacter::applyPinchRotate(float pinchScale, float rotation)
 {
 	switch (state)
 	{
 	case FREERUN:
-	{
-		AddControllerPitchInput(Value);
-		break;
-	}
+	case TOUR:
 	case PANORAMA:
 	{
-		AddControllerPitchInput(Value);
+		AddControllerYawInput(rotation);
 		break;
 	}
 	case ORBIT:
 	{
-		currentXRotationAroundObject -= Value;
-		// Clamp the x rotation around the max values
-		if (currentXRotationAroundObject > maxRotationX)
+		// Spreading the fingers brings the camera closer, but with a table no closer than it was baked at,
+		// the table and the orbit proxy only hold for views at or beyond that distance
+		const float closestDistance = PrecomputedVisibility->hasTable() ? FMath::Max(minRotationDistance, bakedRotationDistance) : minRotationDistance;
+		const float newDistance = FMath::Clamp(rotationDistance / FMath::Max(pinchScale, KINDA_SMALL_NUMBER), closestDistance, maxRotationDistance);
+		if (newDistance != rotationDistance)
 		{
-			currentXRotationAroundObject = maxRotationX;
+			rotationDistance = newDistance;
+			OrbitCamera->startOrbit(rotationObject->GetActorLocation(), rotationDistance);
 		}
-		else if (currentXRotationAroundObject < minRotationX)
+
+		targetZRotationAroundObject += rotation;
+		if (orbitSmoothingTime <= 0.0f)
 		{
-			currentXRotationAroundObject = minRotationX;
+			currentZRotationAroundObject = targetZRotationAroundObject;
 		}
-
 		orbitReposition();
 		break;
 	}
 	}
 }
 
+bool AKilographUnrealAppCharacter::smoothOrbit(float DeltaSeconds)
+{
+	if (orbitSmoothingTime <= 0.0f)
+	{
+		return false;
+	}
+
+	const float remainingX = currentXRotationAroundObject - targetXRotationAroundObject;
+	const float remainingZ = currentZRotationAroundObject - targetZRotationAroundObject;
+	if (FMath::Abs(remainingX) < KINDA_SMALL_NUMBER && FMath::Abs(remainingZ) < KINDA_SMALL_NUMBER &&
+		FMath::Abs(xRotationVelocity) < KINDA_SMALL_NUMBER && FMath::Abs(zRotationVelocity) < KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Critically damped spring, integrated exactly so it stays stable at any frame rate
+	const float omega = 2.0f / orbitSmoothingTime;
+	const float x = omega * DeltaSeconds;
+	const float decay = FMath::Exp(-x);
+
+	const float tempX = (xRotationVelocity + omega * remainingX) * DeltaSeconds;
+	xRotationVelocity = (xRotationVelocity - omega * tempX) * decay;
+	currentXRotationAroundObject = targetXRotationAroundObject + (remainingX + tempX) * decay;
+
+	const float tempZ = (zRotationVelocity + omega * remainingZ) * DeltaSeconds;
+	zRotationVelocity = (zRotationVelocity - omega * tempZ) * decay;
+	currentZRotationAroundObject = targetZRotationAroundObject + (remainingZ + tempZ) * decay;
+
+	return true;
+}
+
+void AKilographUnrealAppCharacter::tapDragX(float Value)
+{
+	applyDrag(Value, 0.0f);
+}
+
+void AKilographUnrealAppCharacter::tapDragY(float Value)
+{
+	applyDrag(0.0f, Value);
+}
+
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////      ORBIT       ///////////////////////////////
 //////////////////////////////////////////////////////////////////////////
+FVector AKilographUnrealAppCharacter::computeOrbitOffset(float xRotation, float zRotation, float distance)
+{
+	return UOrbitCamera::computeOffset(xRotation, zRotation, distance);
+}
+
+void AKilographUnrealAppCharacter::setOrbitAngles(float pitch, float yaw)
+{
+	currentXRotationAroundObject = targetXRotationAroundObject = pitch;
+	currentZRotationAroundObject = targetZRotationAroundObject = yaw;
+	orbitReposition();
+}
+
+// Only the view moves, the orbit camera hands it to the camera manager
 void AKilographUnrealAppCharacter::orbitReposition()
 {
-	FRotator rotation = FRotator::MakeFromEuler(FVector(currentXRotationAroundObject, 0.0f, currentZRotationAroundObject));
-	//Rotation Matrix
-	FRotationMatrix MyRotationMatrix(rotation);
+	SCOPE_CYCLE_COUNTER(STAT_OrbitReposition);
+
+	OrbitCamera->setAngles(currentXRotationAroundObject, currentZRotationAroundObject);
 
-	FVector rotatedPosition = MyRotationMatrix.TransformVector(FVector(0.0f, rotationDistance, 0.0f));
-	SetActorLocation(rotationObject->GetActorLocation() + rotatedPosition);
-	this->GetController()->SetControlRotation(UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), rotationObject->GetActorLocation()));
+	// Pinched out past the baked views the table could hide what has come into view, so it is off out there
+	if (rotationDistance <= bakedRotationDistance)
+	{
+		PrecomputedVisibility->updateOrbit(currentXRotationAroundObject, currentZRotationAroundObject);
+	}
+	else
+	{
+		PrecomputedVisibility->disable();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
 /////////////////////////      SKYBOX       //////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-// Helper function to enable/disable skyboxes
-void AKilographUnrealAppCharacter::hideSkybox(AActor* skybox, bool hide)
+// Helper function to enable/disable the skybox
+void AKilographUnrealAppCharacter::hideSkybox(bool hide)
 {
-	TArray<USceneComponent*> childrenRoots;
-	skybox->GetRootComponent()->GetChildrenComponents(true, childrenRoots);
+	SCOPE_CYCLE_COUNTER(STAT_HideSkybox);
 
-	for (int childIndex = 0; childIndex < childrenRoots.Num(); childIndex++)
-	{
-		childrenRoots[childIndex]->GetOwner()->SetActorHiddenInGame(hide);
-	}
+	VisibilityGroups->setGroupHidden(SkyboxGroup, hide);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -241,87 +428,404 @@ void AKilographUnrealAppCharacter::hideSkybox(AActor* skybox, bool hide)
 //////////////////////////////////////////////////////////////////////////
 void AKilographUnrealAppCharacter::activateCameraFollow()
 {
-	tapDragY(1);
-	state = FREERUN;
-	cameraFollow->startFollowing();
-	hideSkybox(skyboxCenter, true);
+	inputRecorder.record(EInputRecordType::CameraFollow);
+	requestState(TOUR);
 }
 
 void AKilographUnrealAppCharacter::activateOverviewMode()
 {
-	// Zero out player's velocity
-	GetMovementComponent()->StopMovementImmediately();
-	// Stop the camera following mode
-	cameraFollow->stopFollowing();
-	// Start up the orbiting
-	state = ORBIT;
-	currentXRotationAroundObject = 0;
-	currentZRotationAroundObject = 0;
-	orbitReposition();
-	hideSkybox(skyboxCenter, true);
+	inputRecorder.record(EInputRecordType::OverviewMode);
+	requestState(ORBIT);
+}
+
+void AKilographUnrealAppCharacter::activateFreeRun()
+{
+	inputRecorder.record(EInputRecordType::FreeRun);
+	requestState(FREERUN);
 }
 
 void AKilographUnrealAppCharacter::activateSkyboxView()
 {
-	tapDragY(1);
-	state = PANORAMA;
-	// Zero out player's velocity
-	GetMovementComponent()->StopMovementImmediately();
+	inputRecorder.record(EInputRecordType::SkyboxView);
+	requestState(PANORAMA);
+}
+
+void AKilographUnrealAppCharacter::selectPanorama(int32 panoramaIndex)
+{
+	if (!panoramas.IsValidIndex(panoramaIndex))
+	{
+		return;
+	}
+
+	currentPanorama = panoramaIndex;
+	if (state == PANORAMA && !ModeTransition->isTransitioning() && usePanoramaViewer())
+	{
+		panoramaViewer->show(panoramas[currentPanorama]);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+///////////////////////  STATE TRANSITIONS  //////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+// Only the cheap part of leaving the current state happens here, the new state is set up in commitState
+void AKilographUnrealAppCharacter::requestState(AppState newState)
+{
+	FVector targetLocation = GetActorLocation();
+	FRotator targetRotation = GetControlRotation();
+	const FModeResources *resources = NULL;
+
+	// Leaving a walk that has settled, remember where it got to
+	if (state == FREERUN && !ModeTransition->isTransitioning())
+	{
+		walkLocation = GetActorLocation();
+		walkRotation = GetControlRotation();
+	}
+
+	switch (newState)
+	{
+	case ORBIT:
+	{
+		// Blend the eye, not the capsule, to where the orbit view starts
+		targetLocation = rotationObject->GetActorLocation() + computeOrbitOffset(0.0f, 0.0f, rotationDistance);
+		targetRotation = UKismetMathLibrary::FindLookAtRotation(targetLocation, rotationObject->GetActorLocation());
+		targetLocation -= FirstPersonCameraComponent->RelativeLocation;
+		resources = &orbitResources;
+		break;
+	}
+	case TOUR:
+	{
+		const FTourPath &tourPath = cameraFollow->getTourPath();
+		if (tourPath.isValid())
+		{
+			targetLocation = tourPath.getLocationAtDistance(0.0f);
+			if (cameraFollow->orientAlongPath)
+			{
+				targetRotation = tourPath.getDirectionAtDistance(0.0f).Rotation();
+			}
+		}
+		resources = &tourResources;
+		break;
+	}
+	case PANORAMA:
+	{
+		targetLocation = usePanoramaViewer() ? panoramaViewer->GetActorLocation() : skyboxCenter->GetActorLocation();
+		resources = &panoramaResources;
+		break;
+	}
+	case FREERUN:
+	{
+		// The other views are nowhere to walk from, pick up where the player last walked
+		targetLocation = walkLocation;
+		targetRotation = walkRotation;
+		resources = &freerunResources;
+		break;
+	}
+	}
+
+	// Leaving the orbit, bring the character to the orbit view so the blend starts from what is on screen
+	if (OrbitCamera->isOrbiting())
+	{
+		SetActorLocation(OrbitCamera->getCameraLocation() - FirstPersonCameraComponent->RelativeLocation);
+		GetController()->SetControlRotation(OrbitCamera->getCameraRotation());
+		OrbitCamera->stopOrbit();
+		Mesh1P->SetHiddenInGame(false, true);
+		// The interior comes back a little at a time during the blend
+		OrbitProxy->leaveOrbit();
+	}
+
+	if (panoramaViewer != NULL && newState != PANORAMA)
+	{
+		panoramaViewer->hide();
+	}
+
+	// Stop whatever currently moves the player so the blend has sole control
 	cameraFollow->stopFollowing();
-	SetActorLocation(skyboxCenter->GetActorLocation());
+	GetMovementComponent()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	KinematicWalker->stopWalking();
+	// The camera leaves the baked paths while blending
+	PrecomputedVisibility->disable();
 
-	hideSkybox(skyboxCenter, false);
+	// The new state's settings settle in while the view blends
+	QualityGovernor->setState(getStateName(newState));
+
+	pendingState = newState;
+	ModeTransition->begin(*resources, targetLocation, targetRotation);
+}
+
+void AKilographUnrealAppCharacter::commitState()
+{
+	state = pendingState;
+
+	switch (state)
+	{
+	case ORBIT:
+	{
+		// The character stays where the blend left it with movement off, only the view orbits
+		OrbitCamera->startOrbit(rotationObject->GetActorLocation(), rotationDistance);
+		Mesh1P->SetHiddenInGame(true, true);
+		// Start up the orbiting
+		currentXRotationAroundObject = 0;
+		currentZRotationAroundObject = 0;
+		targetXRotationAroundObject = 0;
+		targetZRotationAroundObject = 0;
+		xRotationVelocity = 0;
+		zRotationVelocity = 0;
+		pendingDrag = FVector2D::ZeroVector;
+		// Swap the detail out before the table culls the first orbit cell
+		OrbitProxy->enterOrbit();
+		orbitReposition();
+		hideSkybox(true);
+		// The whole building is in view from the orbit, every zone is brought in until the player walks again
+		ZoneStreamer->loadAllZones();
+		break;
+	}
+	case TOUR:
+	{
+		cameraFollow->startFollowing();
+		hideSkybox(true);
+		ZoneStreamer->startStreaming(cameraFollow);
+		break;
+	}
+	case PANORAMA:
+	{
+		ZoneStreamer->stopStreaming();
+		GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		if (usePanoramaViewer())
+		{
+			SetActorLocation(panoramaViewer->GetActorLocation());
+			panoramaViewer->show(panoramas[currentPanorama]);
+		}
+		else
+		{
+			SetActorLocation(skyboxCenter->GetActorLocation());
+			hideSkybox(false);
+		}
+		break;
+	}
+	case FREERUN:
+	{
+		if (!KinematicWalker->startWalking())
+		{
+			GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		}
+		hideSkybox(true);
+		ZoneStreamer->startStreaming(NULL);
+		break;
+	}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
-///////////////////////  OTHER/MISC/LEGACY  //////////////////////////////
+///////////////////////  RECORD/REPLAY  //////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
-// Trace for hotspots and activate their press functions
-void AKilographUnrealAppCharacter::traceForHotspots()
+// -KiloRecord=<file> records the session's input, -KiloReplay=<file> plays a recording back at a fixed
+// timestep and writes per-state frame costs to -KiloReport=<file> before quitting
+void AKilographUnrealAppCharacter::startInputCapture()
 {
-	FCollisionQueryParams RV_TraceParams = FCollisionQueryParams(FName(TEXT("RV_Trace")), true, this);
-	RV_TraceParams.bTraceComplex = true;
-	RV_TraceParams.bTraceAsyncScene = true;
-	RV_TraceParams.bReturnPhysicalMaterial = false;
+	FString replayPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("KiloReplay="), replayPath))
+	{
+		if (!inputReplayer.load(replayPath))
+		{
+			return;
+		}
 
-	//Re-initialize hit info
-	FHitResult RV_Hit(ForceInit);
+		if (!FParse::Value(FCommandLine::Get(), TEXT("KiloReport="), benchmarkReportPath))
+		{
+			benchmarkReportPath = FPaths::GameSavedDir() / TEXT("Benchmarks") / FPaths::GetBaseFilename(replayPath) + TEXT(".json");
+		}
 
-	// Get the vector from the point the user clicks outwards from the screen
-	FVector worldLocation;
-	FVector worldDirection;
-	bool start = GetWorld()->GetFirstPlayerController()->DeprojectMousePositionToWorld(worldLocation, worldDirection);
+		// Replays always step at a fixed rate so runs are comparable, -benchmark -fps=N picks another rate
+		if (!FApp::IsBenchmarking())
+		{
+			FApp::SetBenchmarking(true);
+			FApp::SetFixedDeltaTime(1.0 / 60.0);
+		}
 
-	if (GetWorld()->LineTraceSingleByChannel(
-		RV_Hit,        //result
-		worldLocation,    //start
-		worldLocation + (worldDirection * 10000), //end
-		ECC_GameTraceChannel2, //collision channel
-		RV_TraceParams
-		))
+		benchmarkState = state;
+#if STATS
+		benchmarkMallocCalls = FMalloc::TotalMallocCalls;
+#endif
+		UE_LOG(Kilograph, Log, TEXT("Replaying input from %s"), *replayPath);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("KiloRecord="), recordingPath))
 	{
-		AActor *hitActor = RV_Hit.GetActor();
-		FOutputDeviceDebug debug;
+		inputRecorder.start();
+		UE_LOG(Kilograph, Log, TEXT("Recording input to %s"), *recordingPath);
+	}
+}
 
-		//UE_LOG(Kilograph, Log, TEXT("Hit actor: %s"), *RV_Hit.GetActor()->GetName());
+void AKilographUnrealAppCharacter::replayInput(float DeltaSeconds)
+{
+	// The game thread time of the frame that just finished belongs to the state it ran in
+	uint32 allocations = 0;
+#if STATS
+	allocations = FMalloc::TotalMallocCalls - benchmarkMallocCalls;
+	benchmarkMallocCalls = FMalloc::TotalMallocCalls;
+#endif
+	replayBenchmark.addFrame(getStateName(benchmarkState), FPlatformTime::ToMilliseconds(GGameThreadTime), allocations);
+
+	if (inputReplayer.isFinished())
+	{
+		replayBenchmark.writeReport(benchmarkReportPath);
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
 
-		TArray<UActorComponent *> actorComponents;
-		hitActor->GetComponents(actorComponents);
+	TArray<FInputRecordEvent> dueEvents;
+	inputReplayer.advance(DeltaSeconds, dueEvents);
+	for (int eventIndex = 0; eventIndex < dueEvents.Num(); eventIndex++)
+	{
+		const FInputRecordEvent &event = dueEvents[eventIndex];
+		const ETouchIndex::Type fingerIndex = (ETouchIndex::Type)event.fingerIndex;
+		const FVector location(event.location, 0.0f);
 
-		for (int componentIndex = 0; componentIndex < actorComponents.Num(); componentIndex++)
+		switch (event.type)
 		{
-			FString componentName = *actorComponents[componentIndex]->GetClass()->GetName();
+		case EInputRecordType::BeginTouch:
+			BeginTouch(fingerIndex, location);
+			break;
+		case EInputRecordType::EndTouch:
+			EndTouch(fingerIndex, location);
+			break;
+		case EInputRecordType::TouchUpdate:
+			TouchUpdate(fingerIndex, location);
+			break;
+		case EInputRecordType::SkyboxView:
+			activateSkyboxView();
+			break;
+		case EInputRecordType::CameraFollow:
+			activateCameraFollow();
+			break;
+		case EInputRecordType::OverviewMode:
+			activateOverviewMode();
+			break;
+		case EInputRecordType::FreeRun:
+			activateFreeRun();
+			break;
+		}
+	}
 
-			if (componentName.Compare("Hotspot_C") == 0)
-			{
-				//UE_LOG(Kilograph, Log, TEXT("Hotspot found"));
-				actorComponents[componentIndex]->CallFunctionByNameWithArguments(TEXT("Press"), debug, NULL, true);
-			}
-			//UE_LOG(Kilograph, Log, TEXT("Actor component name: %s"), *componentName);
+	benchmarkState = state;
+}
+
+const TCHAR* AKilographUnrealAppCharacter::getStateName(AppState appState)
+{
+	switch (appState)
+	{
+	case ORBIT:
+		return TEXT("ORBIT");
+	case FREERUN:
+		return TEXT("FREERUN");
+	case TOUR:
+		return TEXT("TOUR");
+	case PANORAMA:
+		return TEXT("PANORAMA");
+	}
+	return TEXT("UNKNOWN");
+}
+
+void AKilographUnrealAppCharacter::exportModeStats(const FString &path)
+{
+	modeProfiler.writeCsv(path.IsEmpty() ? FPaths::GameSavedDir() / TEXT("Profiling") / FString::Printf(TEXT("ModeStats-%s.csv"), *FDateTime::Now().ToString()) : path);
+}
+
+//////////////////////////////////////////////////////////////////////////
+///////////////////////  OTHER/MISC/LEGACY  //////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+// Resolve taps against the hotspot registry, the hotspots hit are pressed once their line of sight traces come back
+void AKilographUnrealAppCharacter::traceForHotspots(const TArray<FVector> &screenLocations)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TraceForHotspots);
+
+	UHotspotRegistry *registry = UHotspotRegistry::get(this);
+	APlayerController *playerController = Cast<APlayerController>(GetController());
+	if (registry == NULL || playerController == NULL)
+	{
+		return;
+	}
+
+	TArray<UHotspotComponent *> tracedHotspots;
+	for (int32 tapIndex = 0; tapIndex < screenLocations.Num(); tapIndex++)
+	{
+		// Get the vector from the point the user taps outwards from the screen
+		FVector worldLocation;
+		FVector worldDirection;
+		if (!playerController->DeprojectScreenPositionToWorld(screenLocations[tapIndex].X, screenLocations[tapIndex].Y, worldLocation, worldDirection))
+		{
+			continue;
 		}
+
+		float hotspotDistance;
+		UHotspotComponent *hotspot = registry->raycast(worldLocation, worldDirection, 10000.0f, hotspotDistance);
+		if (hotspot == NULL || tracedHotspots.Contains(hotspot))
+		{
+			continue;
+		}
+		tracedHotspots.Add(hotspot);
+
+		// Simple collision first, the complex meshes are only traced if a simple proxy is in the way
+		FHotspotTrace trace;
+		trace.id = nextHotspotTraceId++;
+		trace.hotspot = hotspot;
+		trace.start = worldLocation;
+		trace.end = worldLocation + (worldDirection * hotspotDistance);
+		trace.complex = false;
+		submitHotspotTrace(trace);
 	}
 }
 
+void AKilographUnrealAppCharacter::submitHotspotTrace(const FHotspotTrace &trace)
+{
+	// Make sure no geometry stands between the user and the hotspot
+	FCollisionQueryParams RV_TraceParams = FCollisionQueryParams(FName(TEXT("RV_Trace")), trace.complex, this);
+	RV_TraceParams.bTraceAsyncScene = true;
+	RV_TraceParams.bReturnPhysicalMaterial = false;
+	RV_TraceParams.AddIgnoredActor(trace.hotspot->GetOwner());
+
+	hotspotTraces.Add(trace);
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, trace.start, trace.end, ECC_GameTraceChannel2,
+		RV_TraceParams, FCollisionResponseParams::DefaultResponseParam, &hotspotTraceDelegate, trace.id);
+}
+
+void AKilographUnrealAppCharacter::onHotspotTraceDone(const FTraceHandle &handle, FTraceDatum &datum)
+{
+	int32 traceIndex = INDEX_NONE;
+	for (int32 index = 0; index < hotspotTraces.Num(); index++)
+	{
+		if (hotspotTraces[index].id == datum.UserData)
+		{
+			traceIndex = index;
+			break;
+		}
+	}
+	if (traceIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FHotspotTrace trace = hotspotTraces[traceIndex];
+	hotspotTraces.RemoveAtSwap(traceIndex);
+	UHotspotComponent *hotspot = trace.hotspot.Get();
+	if (hotspot == NULL)
+	{
+		return;
+	}
+
+	const bool blocked = datum.OutHits.Num() > 0 && datum.OutHits[0].bBlockingHit;
+	if (!blocked)
+	{
+		hotspot->press();
+	}
+	else if (!trace.complex)
+	{
+		// Simple proxies are coarser than the meshes, check the actual geometry before giving up
+		FHotspotTrace complexTrace = trace;
+		complexTrace.complex = true;
+		submitHotspotTrace(complexTrace);
+	}
+}
 
 bool AKilographUnrealAppCharacter::EnableTouchscreenMovement(class UInputComponent* InputComponent)
 {
@@ -366,4 +870,16 @@ void AKilographUnrealAppCharacter::LookUpAtRate(float Rate)
 	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
 }
 
-void AKilographUnrealAppCharacter::OnFire(){}
\ No newline at end of file
+void AKilographUnrealAppCharacter::OnFire()
+{
+	UProjectilePool *projectilePool = UProjectilePool::get(this);
+	if (ProjectileClass == NULL || projectilePool == NULL)
+	{
+		return;
+	}
+
+	const FRotator SpawnRotation = GetControlRotation();
+	// GunOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+	const FVector SpawnLocation = GetActorLocation() + SpawnRotation.RotateVector(GunOffset);
+	projectilePool->acquire(ProjectileClass, SpawnLocation, SpawnRotation);
+}
\ No newline at end of file
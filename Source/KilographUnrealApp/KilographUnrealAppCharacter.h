@@ -1,13 +1,18 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #pragma once
 #include "CameraFollow.h"
+#include "InputRecording.h"
+#include "ModeProfiler.h"
+#include "ModeTransition.h"
+#include "TouchGestures.h"
+#include "WorldCollision.h"
 #include "GameFramework/Character.h"
 #include "KilographUnrealAppCharacter.generated.h"
 
 class UInputComponent;
 
 UCLASS(config=Game)
-class AKilographUnrealAppCharacter : public ACharacter
+class KILOGRAPHUNREALAPP_API AKilographUnrealAppCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
@@ -22,9 +27,47 @@ class AKilographUnrealAppCharacter : public ACharacter
 	/** First person camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FirstPersonCameraComponent;
+
+	/** Cached actor sets shown and hidden per mode, such as the skybox */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UVisibilityGroups* VisibilityGroups;
+
+	/** Baked culling applied while on the tour or the orbit */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UPrecomputedVisibility* PrecomputedVisibility;
+
+	/** Blends between states while the next state's resources warm up */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UModeTransition* ModeTransition;
+
+	/** View used while orbiting, handed to the camera manager so the character stays put */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UOrbitCamera* OrbitCamera;
+
+	/** Scales render settings to hold each state's frame time */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UQualityGovernor* QualityGovernor;
+
+	/** Streams the floors and cells around the player while walking or touring */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UZoneStreamer* ZoneStreamer;
+
+	/** Swaps the interior out, and the exterior for its proxy, while orbiting */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UOrbitProxy* OrbitProxy;
+
+	/** Walks the player without the character movement pipeline when enabled */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Control, meta = (AllowPrivateAccess = "true"))
+	class UKinematicWalker* KinematicWalker;
 public:
 	AKilographUnrealAppCharacter();
 
+	// Applies the input gathered during the frame
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Saves any input recording in progress
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
 	float BaseTurnRate;
@@ -37,6 +80,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	FVector GunOffset;
 
+	/** Projectile class to fire, nothing is fired if unset */
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+	TSubclassOf<class AKilographUnrealAppProjectile> ProjectileClass;
+
+	/** Projectiles spawned into the pool up front, size it so firing never misses the pool */
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+	int32 projectilePoolSize;
+
 	/** Sound to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	class USoundBase* FireSound;
@@ -53,6 +104,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
 	float rotationDistance;
 
+	// Closest the orbit can be pinched in to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
+	float minRotationDistance;
+
+	// Furthest the orbit can be pinched out to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
+	float maxRotationDistance;
+
 	// Clamp the possible rotation values
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
 	float maxRotationX;
@@ -61,6 +120,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
 	float minRotationX;
 
+	// Time for the orbit to settle on the dragged position, 0 follows drags immediately
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
+	float orbitSmoothingTime;
+
 	// Actor that contains path the camera will follow
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
 	class AActor* cameraFollowActor;
@@ -69,10 +132,76 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
 	class AActor* skyboxCenter;
 
+	// Viewer streaming the tiled panoramas, the skybox is shown instead when there is none
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
+	class APanoramaViewer* panoramaViewer;
+
+	// Panoramas the viewer can show
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Control)
+	TArray<class UPanoramaAsset*> panoramas;
+
+	/** States the player can be in */
+	enum AppState
+	{
+		ORBIT,
+		FREERUN,
+		TOUR,
+		PANORAMA
+	};
+
+	// Current state of the player
+	AppState getState() const { return state; }
+
+	// Pitch and yaw the orbit is shown at
+	float getOrbitPitch() const { return currentXRotationAroundObject; }
+	float getOrbitYaw() const { return currentZRotationAroundObject; }
+
+	// Pitch the orbit is easing towards while smoothing
+	float getTargetOrbitPitch() const { return targetXRotationAroundObject; }
+
+	// Place the orbit view at a pitch and yaw right away
+	void setOrbitAngles(float pitch, float yaw);
+
+	// Handles tap and drag input within various states along both axes in one update
+	void applyDrag(float deltaX, float deltaY);
+
+	// Name of a state as used in logs and reports
+	static const TCHAR* getStateName(AppState appState);
+
+	// Rolling frame costs of each state
+	const FModeProfiler &getModeProfiler() const { return modeProfiler; }
+
+	// Console command writing the per state frame costs to a CSV file, Saved/Profiling by default
+	UFUNCTION(Exec)
+	void exportModeStats(const FString &path);
+
+	// Resources warmed before the orbit takes over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	FModeResources orbitResources;
+
+	// Resources warmed before the tour takes over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	FModeResources tourResources;
+
+	// Resources warmed before the panorama takes over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	FModeResources panoramaResources;
+
+	// Resources warmed before walking takes over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	FModeResources freerunResources;
+
+	// Offset from the orbit target of a camera orbiting at the given rotations and distance
+	static FVector computeOrbitOffset(float xRotation, float zRotation, float distance);
+
 	// Function callback to activate skybox viewing mode
 	UFUNCTION(BlueprintCallable, Category = "Custom")
 	void activateSkyboxView();
 
+	// Switch the panorama shown by the viewer, shown right away when already viewing panoramas
+	UFUNCTION(BlueprintCallable, Category = "Custom")
+	void selectPanorama(int32 panoramaIndex);
+
 	// Function callback to activate camera following
 	UFUNCTION(BlueprintCallable, Category = "Custom")
 	void activateCameraFollow();
@@ -81,33 +210,107 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Custom")
 	void activateOverviewMode();
 
+	// Function callback to walk again from where the player last walked
+	UFUNCTION(BlueprintCallable, Category = "Custom")
+	void activateFreeRun();
+
 private:
+	/** Where the player last walked, free run picks up from there */
+	FVector walkLocation;
+	FRotator walkRotation;
+
+	/** Orbit distance the visibility table was baked at, the pinch doesn't go inside it while there is a table */
+	float bakedRotationDistance;
+
 	/** Variables handling the player orbiting around a point */
 	float currentXRotationAroundObject;
 	float currentZRotationAroundObject;
 
-	class UCameraFollow *cameraFollow;
+	/** Orbit the player is being smoothed towards, and the smoothing velocities */
+	float targetXRotationAroundObject;
+	float targetZRotationAroundObject;
+	float xRotationVelocity;
+	float zRotationVelocity;
 
-	/** Handles the player's state */
-	enum AppState
+	/** Drag accumulated from touch gestures since the last tick */
+	FVector2D pendingDrag;
+
+	/** Taps made since the last tick, resolved against the hotspots together */
+	TArray<FVector> pendingTaps;
+
+	/** Line of sight check to a hotspot running on the async trace queue */
+	struct FHotspotTrace
 	{
-		ORBIT,
-		FREERUN,
-		TOUR,
-		PANORAMA
+		uint32 id;
+		TWeakObjectPtr<class UHotspotComponent> hotspot;
+		FVector start;
+		FVector end;
+		bool complex;
 	};
+	TArray<FHotspotTrace> hotspotTraces;
+	uint32 nextHotspotTraceId;
+	FTraceDelegate hotspotTraceDelegate;
+
+	class UCameraFollow *cameraFollow;
+
+	/** Panorama the viewer shows */
+	int32 currentPanorama;
+
+	/** Handles the player's state */
 	AppState state;
 
+	/** State being transitioned to */
+	AppState pendingState;
+
+	/** Rolling frame costs of each state */
+	FModeProfiler modeProfiler;
+
+	/** Input capture and playback for benchmarks, enabled from the command line */
+	FInputRecorder inputRecorder;
+	FInputReplayer inputReplayer;
+	FReplayBenchmark replayBenchmark;
+	FString recordingPath;
+	FString benchmarkReportPath;
+	AppState benchmarkState;
+	uint32 benchmarkMallocCalls;
+
 protected:
-	// Trace for hotspots and activate their press functions
-	void traceForHotspots();
+	// Start recording or replaying input if requested on the command line
+	void startInputCapture();
+
+	// Feed the recorded inputs that are due and account the frame to the current state
+	void replayInput(float DeltaSeconds);
+
+	// Resolve the taps made since the last tick against the hotspot registry and queue their line of sight traces
+	void traceForHotspots(const TArray<FVector> &screenLocations);
 
-	// Helper function to enable/disable skyboxes
-	void hideSkybox(AActor* skybox, bool hide);
+	// Queue a line of sight trace to a hotspot, the result arrives next frame
+	void submitHotspotTrace(const FHotspotTrace &trace);
+
+	// Press the hotspot if nothing blocked the view of it, confirming blocks by simple collision with a complex trace
+	void onHotspotTraceDone(const FTraceHandle &handle, FTraceDatum &datum);
+
+	// Helper function to enable/disable the skybox
+	void hideSkybox(bool hide);
+
+	// Whether the panorama state shows the streamed panoramas rather than the skybox
+	bool usePanoramaViewer() const { return panoramaViewer != NULL && panoramas.IsValidIndex(currentPanorama) && panoramas[currentPanorama] != NULL; }
+
+	// Start blending to a new state while its resources warm up
+	void requestState(AppState newState);
+
+	// Called by the transition once the pending state can take over
+	void commitState();
 
 	// Helper function to reposition the player given the current orbit status
 	void orbitReposition();
 
+	// Move the orbit towards its target, returns true if the orbit changed
+	bool smoothOrbit(float DeltaSeconds);
+
+	// Handles two finger pinches and rotations within various states
+	void applyPinchRotate(float pinchScale, float rotation);
+
 	// Handles tap and drag input within various states along the x axis
 	void tapDragX(float deltaX);
 
@@ -135,18 +338,11 @@ protected:
 	*/
 	void LookUpAtRate(float Rate);
 
-	struct TouchData
-	{
-		TouchData() { bIsPressed = false; Location = FVector::ZeroVector; }
-		bool bIsPressed;
-		ETouchIndex::Type FingerIndex;
-		FVector Location;
-		bool bMoved;
-	};
 	void BeginTouch(const ETouchIndex::Type FingerIndex, const FVector Location);
 	void EndTouch(const ETouchIndex::Type FingerIndex, const FVector Location);
 	void TouchUpdate(const ETouchIndex::Type FingerIndex, const FVector Location);
-	TouchData	TouchItem;
+	FTouchGestureRecognizer touchGestures;
+	FTouchGestures frameGestures;
 
 protected:
 	// APawn interface
@@ -166,5 +362,21 @@ public:
 	FORCEINLINE class USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
 	/** Returns FirstPersonCameraComponent subobject **/
 	FORCEINLINE class UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
+	/** Returns VisibilityGroups subobject **/
+	FORCEINLINE class UVisibilityGroups* GetVisibilityGroups() const { return VisibilityGroups; }
+	/** Returns PrecomputedVisibility subobject **/
+	FORCEINLINE class UPrecomputedVisibility* GetPrecomputedVisibility() const { return PrecomputedVisibility; }
+	/** Returns ModeTransition subobject **/
+	FORCEINLINE class UModeTransition* GetModeTransition() const { return ModeTransition; }
+	/** Returns OrbitCamera subobject **/
+	FORCEINLINE class UOrbitCamera* GetOrbitCamera() const { return OrbitCamera; }
+	/** Returns QualityGovernor subobject **/
+	FORCEINLINE class UQualityGovernor* GetQualityGovernor() const { return QualityGovernor; }
+	/** Returns ZoneStreamer subobject **/
+	FORCEINLINE class UZoneStreamer* GetZoneStreamer() const { return ZoneStreamer; }
+	/** Returns OrbitProxy subobject **/
+	FORCEINLINE class UOrbitProxy* GetOrbitProxy() const { return OrbitProxy; }
+	/** Returns KinematicWalker subobject **/
+	FORCEINLINE class UKinematicWalker* GetKinematicWalker() const { return KinematicWalker; }
 };
 
@@ -4,14 +4,48 @@
 #include "KilographUnrealAppGameMode.h"
 #include "KilographUnrealAppHUD.h"
 #include "KilographUnrealAppCharacter.h"
+#include "KilographUnrealAppPlayerController.h"
+#include "HotspotRegistry.h"
+#include "ProjectilePool.h"
+#include "StartupLoader.h"
 
 AKilographUnrealAppGameMode::AKilographUnrealAppGameMode()
 	: Super()
 {
-	// set default pawn class to our Blueprinted character
+	// set default pawn class to our Blueprinted character. This stays a synchronous load, the pawn is
+	// spawned as soon as the player logs in and everything else is streamed in around it.
 	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnClassFinder(TEXT("/Game/FirstPersonCPP/Blueprints/FirstPersonCharacter"));
 	DefaultPawnClass = PlayerPawnClassFinder.Class;
 
 	// use our custom HUD class
 	HUDClass = AKilographUnrealAppHUD::StaticClass();
+
+	// use our controller so the orbit can drive the view through the camera manager
+	PlayerControllerClass = AKilographUnrealAppPlayerController::StaticClass();
+
+	// Hotspots register themselves here as they begin play
+	hotspotRegistry = CreateDefaultSubobject<UHotspotRegistry>(TEXT("HotspotRegistry"));
+
+	// Streams the orbit, tour and panorama content in that order once play starts
+	startupLoader = CreateDefaultSubobject<UStartupLoader>(TEXT("StartupLoader"));
+
+	// Projectiles are fired from and returned to this pool
+	projectilePool = CreateDefaultSubobject<UProjectilePool>(TEXT("ProjectilePool"));
+}
+
+void AKilographUnrealAppGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	startupLoader->addStage(TEXT("Orbit"), orbitAssets);
+	startupLoader->addStage(TEXT("Tour"), tourAssets);
+	startupLoader->addStage(TEXT("Panorama"), panoramaAssets);
+	startupLoader->start();
+}
+
+void AKilographUnrealAppGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	projectilePool->logStats();
+
+	Super::EndPlay(EndPlayReason);
 }
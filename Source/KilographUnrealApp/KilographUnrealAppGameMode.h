@@ -3,13 +3,53 @@
 #include "GameFramework/GameMode.h"
 #include "KilographUnrealAppGameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, config=Game)
 class AKilographUnrealAppGameMode : public AGameMode
 {
 	GENERATED_BODY()
 
 public:
 	AKilographUnrealAppGameMode();
+
+	/** Content needed by the orbit view, streamed first */
+	UPROPERTY(EditAnywhere, config, Category = Startup)
+	TArray<FStringAssetReference> orbitAssets;
+
+	/** Content needed by the camera tour, streamed once the orbit content is in */
+	UPROPERTY(EditAnywhere, config, Category = Startup)
+	TArray<FStringAssetReference> tourAssets;
+
+	/** Content needed by the panoramas, streamed last */
+	UPROPERTY(EditAnywhere, config, Category = Startup)
+	TArray<FStringAssetReference> panoramaAssets;
+
+	/** Starts streaming the startup content */
+	virtual void StartPlay() override;
+
+	/** Reports how well the projectile pool was sized */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Returns the registry of hotspots in play **/
+	FORCEINLINE class UHotspotRegistry* getHotspotRegistry() const { return hotspotRegistry; }
+
+	/** Returns the loader streaming content in at startup **/
+	FORCEINLINE class UStartupLoader* getStartupLoader() const { return startupLoader; }
+
+	/** Returns the pool projectiles are fired from **/
+	FORCEINLINE class UProjectilePool* getProjectilePool() const { return projectilePool; }
+
+private:
+	/** Spatial index of every hotspot in the world */
+	UPROPERTY()
+	class UHotspotRegistry* hotspotRegistry;
+
+	/** Streams the startup content */
+	UPROPERTY()
+	class UStartupLoader* startupLoader;
+
+	/** Recycled projectiles */
+	UPROPERTY()
+	class UProjectilePool* projectilePool;
 };
 
 
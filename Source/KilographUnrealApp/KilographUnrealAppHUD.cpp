@@ -2,15 +2,41 @@
 
 #include "KilographUnrealApp.h"
 #include "KilographUnrealAppHUD.h"
+#include "StartupLoader.h"
+#include "HotspotRegistry.h"
+#include "KilographUnrealAppCharacter.h"
 #include "Engine/Canvas.h"
 #include "TextureResource.h"
 #include "CanvasItem.h"
 
 AKilographUnrealAppHUD::AKilographUnrealAppHUD()
 {
-	// Set the crosshair texture
-	static ConstructorHelpers::FObjectFinder<UTexture2D> CrosshiarTexObj(TEXT("/Game/FirstPerson/Textures/FirstPersonCrosshair"));
-	CrosshairTex = CrosshiarTexObj.Object;
+	// Set the crosshair texture, it is loaded asynchronously once play begins
+	CrosshairAsset = FStringAssetReference(TEXT("/Game/FirstPerson/Textures/FirstPersonCrosshair.FirstPersonCrosshair"));
+	CrosshairTex = NULL;
+	showModeOverlay = false;
+	showHotspotLabels = false;
+}
+
+void AKilographUnrealAppHUD::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UStartupLoader* Loader = UStartupLoader::get(this);
+	if (Loader != NULL)
+	{
+		Loader->getStreamableManager().RequestAsyncLoad(CrosshairAsset.ToStringReference(), FStreamableDelegate::CreateUObject(this, &AKilographUnrealAppHUD::onCrosshairLoaded));
+	}
+	else
+	{
+		// Game modes without the startup loader get the crosshair straight away, as before streaming
+		CrosshairTex = Cast<UTexture2D>(CrosshairAsset.ToStringReference().TryLoad());
+	}
+}
+
+void AKilographUnrealAppHUD::onCrosshairLoaded()
+{
+	CrosshairTex = CrosshairAsset.Get();
 }
 
 
@@ -18,6 +44,22 @@ void AKilographUnrealAppHUD::DrawHUD()
 {
 	Super::DrawHUD();
 
+	if (showHotspotLabels)
+	{
+		drawHotspotLabels();
+	}
+
+	if (showModeOverlay)
+	{
+		drawModeOverlay();
+	}
+
+	// Nothing to draw until the crosshair has streamed in
+	if (CrosshairTex == NULL)
+	{
+		return;
+	}
+
 	// Draw very simple crosshair
 
 	// find center of the Canvas
@@ -33,3 +75,70 @@ void AKilographUnrealAppHUD::DrawHUD()
 	Canvas->DrawItem( TileItem );
 }
 
+void AKilographUnrealAppHUD::toggleModeOverlay()
+{
+	showModeOverlay = !showModeOverlay;
+}
+
+void AKilographUnrealAppHUD::toggleHotspotLabels()
+{
+	showHotspotLabels = !showHotspotLabels;
+}
+
+void AKilographUnrealAppHUD::drawHotspotLabels()
+{
+	if (PlayerOwner == NULL || PlayerOwner->PlayerCameraManager == NULL)
+	{
+		return;
+	}
+
+	FVector viewLocation;
+	FRotator viewRotation;
+	PlayerOwner->PlayerCameraManager->GetCameraViewPoint(viewLocation, viewRotation);
+	hotspotLabels.draw(Canvas, GEngine->GetSmallFont(), UHotspotRegistry::get(this), viewLocation, viewRotation, PlayerOwner->PlayerCameraManager->GetFOVAngle());
+}
+
+void AKilographUnrealAppHUD::drawModeOverlay()
+{
+	AKilographUnrealAppCharacter *character = Cast<AKilographUnrealAppCharacter>(GetOwningPawn());
+	if (character == NULL)
+	{
+		return;
+	}
+
+	UFont *font = GEngine->GetSmallFont();
+	const float lineHeight = font->GetMaxCharHeight() + 2.0f;
+	const FString currentMode = AKilographUnrealAppCharacter::getStateName(character->getState());
+	const FModeProfiler &profiler = character->getModeProfiler();
+	float y = 50.0f;
+
+	FString bucketHeader;
+	for (int32 bucket = 0; bucket < FModeProfiler::NumFrameTimeBuckets; bucket++)
+	{
+		bucketHeader += FString::Printf(TEXT(" %9s"), *FModeProfiler::getBucketLabel(bucket));
+	}
+	DrawText(FString::Printf(TEXT("%-9s %8s %8s %8s %6s %8s |%s"), TEXT("MODE"), TEXT("AVG MS"), TEXT("P95 MS"), TEXT("MAX MS"), TEXT("DRAWS"), TEXT("MEM MB"), *bucketHeader),
+		FLinearColor::White, 20.0f, y, font);
+	y += lineHeight;
+
+	const TArray<FString> &modeNames = profiler.getModeNames();
+	for (int32 modeIndex = 0; modeIndex < modeNames.Num(); modeIndex++)
+	{
+		FModeProfiler::FSummary summary;
+		if (!profiler.summarize(modeNames[modeIndex], summary))
+		{
+			continue;
+		}
+
+		FString buckets;
+		for (int32 bucket = 0; bucket < FModeProfiler::NumFrameTimeBuckets; bucket++)
+		{
+			buckets += FString::Printf(TEXT(" %9d"), summary.frameTimeBuckets[bucket]);
+		}
+
+		const FString line = FString::Printf(TEXT("%-9s %8.2f %8.2f %8.2f %6.0f %8.1f |%s"), *modeNames[modeIndex],
+			summary.averageFrameMs, summary.p95FrameMs, summary.maxFrameMs, summary.averageDrawCalls, summary.averageMemoryMB, *buckets);
+		DrawText(line, modeNames[modeIndex] == currentMode ? FLinearColor::Yellow : FLinearColor::White, 20.0f, y, font);
+		y += lineHeight;
+	}
+}
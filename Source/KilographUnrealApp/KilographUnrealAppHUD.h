@@ -1,6 +1,7 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #pragma once 
 #include "GameFramework/HUD.h"
+#include "HotspotLabels.h"
 #include "KilographUnrealAppHUD.generated.h"
 
 UCLASS()
@@ -11,11 +12,46 @@ class AKilographUnrealAppHUD : public AHUD
 public:
 	AKilographUnrealAppHUD();
 
+	/** Starts streaming the crosshair texture */
+	virtual void BeginPlay() override;
+
 	/** Primary draw call for the HUD */
 	virtual void DrawHUD() override;
 
+	/** Show the rolling frame costs of each state on screen */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profiling)
+	bool showModeOverlay;
+
+	/** Console command showing or hiding the state cost overlay */
+	UFUNCTION(Exec)
+	void toggleModeOverlay();
+
+	/** Label the hotspots in view, off until the scene's hotspots are given labels */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hotspots)
+	bool showHotspotLabels;
+
+	/** Console command showing or hiding the hotspot labels */
+	UFUNCTION(Exec)
+	void toggleHotspotLabels();
+
 private:
-	/** Crosshair asset pointer */
+	/** Called once the crosshair texture is resident */
+	void onCrosshairLoaded();
+
+	/** Draws the frame costs of each state the player has been in, the current one highlighted */
+	void drawModeOverlay();
+
+	/** Draws the labels of the hotspots in front of the player's camera */
+	void drawHotspotLabels();
+
+	/** Cached layout of the hotspot labels */
+	FHotspotLabels hotspotLabels;
+
+	/** Crosshair asset, streamed in after startup */
+	TAssetPtr<UTexture2D> CrosshairAsset;
+
+	/** Crosshair asset pointer, NULL until the asset is loaded */
+	UPROPERTY()
 	class UTexture2D* CrosshairTex;
 
 };
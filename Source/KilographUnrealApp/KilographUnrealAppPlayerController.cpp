@@ -0,0 +1,10 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "KilographUnrealAppPlayerController.h"
+#include "KilographUnrealAppCameraManager.h"
+
+AKilographUnrealAppPlayerController::AKilographUnrealAppPlayerController()
+{
+	PlayerCameraManagerClass = AKilographUnrealAppCameraManager::StaticClass();
+}
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/PlayerController.h"
+#include "KilographUnrealAppPlayerController.generated.h"
+
+/**
+ * Player controller of the app, only there to use the app's camera manager.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API AKilographUnrealAppPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AKilographUnrealAppPlayerController();
+};
@@ -2,6 +2,7 @@
 
 #include "KilographUnrealApp.h"
 #include "KilographUnrealAppProjectile.h"
+#include "ProjectilePool.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 
 AKilographUnrealAppProjectile::AKilographUnrealAppProjectile() 
@@ -27,8 +28,16 @@ AKilographUnrealAppProjectile::AKilographUnrealAppProjectile()
 	ProjectileMovement->bRotationFollowsVelocity = true;
 	ProjectileMovement->bShouldBounce = true;
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 3.0f;
+	// Die after 3 seconds by default. The timer is run by the projectile itself rather than through
+	// InitialLifeSpan so pooled projectiles are recycled instead of destroyed.
+	lifeSpan = 3.0f;
+}
+
+void AKilographUnrealAppProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	GetWorldTimerManager().SetTimer(lifeSpanTimer, this, &AKilographUnrealAppProjectile::recycle, lifeSpan, false);
 }
 
 void AKilographUnrealAppProjectile::OnHit(AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -38,6 +47,48 @@ void AKilographUnrealAppProjectile::OnHit(AActor* OtherActor, UPrimitiveComponen
 	{
 		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
 
+		recycle();
+	}
+}
+
+void AKilographUnrealAppProjectile::setPool(UProjectilePool* poolInput)
+{
+	pool = poolInput;
+}
+
+void AKilographUnrealAppProjectile::launch(const FVector& location, const FRotator& rotation)
+{
+	SetActorLocationAndRotation(location, rotation);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// A projectile that came to rest stopped simulating, which clears its updated component, so hook it back up and give it a fresh velocity
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->UpdateComponentVelocity();
+	ProjectileMovement->SetComponentTickEnabled(true);
+
+	GetWorldTimerManager().SetTimer(lifeSpanTimer, this, &AKilographUnrealAppProjectile::recycle, lifeSpan, false);
+}
+
+void AKilographUnrealAppProjectile::retire()
+{
+	GetWorldTimerManager().ClearTimer(lifeSpanTimer);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->SetComponentTickEnabled(false);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+void AKilographUnrealAppProjectile::recycle()
+{
+	if (pool.IsValid())
+	{
+		pool->release(this);
+	}
+	else
+	{
 		Destroy();
 	}
 }
\ No newline at end of file
@@ -16,13 +16,38 @@ class AKilographUnrealAppProjectile : public AActor
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	class UProjectileMovementComponent* ProjectileMovement;
 
+	/** Pool the projectile returns to when it is done, NULL if it was spawned on its own */
+	TWeakObjectPtr<class UProjectilePool> pool;
+
+	/** Timer ending the projectile's flight */
+	FTimerHandle lifeSpanTimer;
+
 public:
 	AKilographUnrealAppProjectile();
 
+	/** Seconds a projectile flies before it is recycled */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float lifeSpan;
+
+	/** Starts the flight timer */
+	virtual void BeginPlay() override;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/** Marks the projectile as owned by a pool */
+	void setPool(class UProjectilePool* poolInput);
+
+	/** Resets the projectile and fires it from the given location */
+	void launch(const FVector& location, const FRotator& rotation);
+
+	/** Stops the projectile and parks it, hidden and without collision, until it is launched again */
+	void retire();
+
+	/** Ends the projectile's flight, returning it to its pool or destroying it */
+	void recycle();
+
 	/** Returns CollisionComp subobject **/
 	FORCEINLINE class USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "KinematicWalker.h"
+#include "GameFramework/PawnMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Kinematic Walk"), STAT_KinematicWalk, STATGROUP_Kilograph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Walk Sweeps"), STAT_WalkSweeps, STATGROUP_Kilograph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Traces"), STAT_FloorTraces, STATGROUP_Kilograph);
+
+// Height stored for cells with nothing to stand on
+static const float NoFloor = -BIG_NUMBER;
+
+// Surfaces steeper than this are walls rather than floor
+static const float WalkableNormalZ = 0.7f;
+
+// Times the capsule slides along what it hits in one move
+static const int32 MaxSlides = 2;
+
+// Gap kept between the capsule and what it hits
+static const float SlideSkin = 0.5f;
+
+static const FName FloorTraceTag(TEXT("KinematicWalkFloor"));
+static const FName SlideTraceTag(TEXT("KinematicWalkSlide"));
+
+// Cells and bands packed into a key, twenty bits each way and twenty four for the band
+static uint64 makeFloorKey(int32 cellX, int32 cellY, int32 band)
+{
+	return ((uint64)((uint32)cellX & 0xFFFFF) << 44) | ((uint64)((uint32)cellY & 0xFFFFF) << 24) | (uint64)((uint32)band & 0xFFFFFF);
+}
+
+// Sets default values for this component's properties
+UKinematicWalker::UKinematicWalker()
+{
+	// Only ticks while walking
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	enabled = false;
+	walkSpeed = 600.0f;
+	acceleration = 2048.0f;
+	maxStepHeight = 45.0f;
+	maxDropHeight = 200.0f;
+	floorFollowSpeed = 15.0f;
+	floorCellSize = 50.0f;
+	maxFloorCells = 16384;
+	walking = false;
+	velocity = FVector::ZeroVector;
+	currentFloorHeight = NoFloor;
+}
+
+// Called when the game starts
+void UKinematicWalker::BeginPlay()
+{
+	Super::BeginPlay();
+
+	levelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UKinematicWalker::onLevelsChanged);
+	levelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UKinematicWalker::onLevelsChanged);
+}
+
+// Called when the component is removed from play
+void UKinematicWalker::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(levelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(levelRemovedHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UKinematicWalker::startWalking()
+{
+	APawn *pawn = Cast<APawn>(GetOwner());
+	if (!enabled || pawn == NULL)
+	{
+		return false;
+	}
+
+	UPawnMovementComponent *movement = pawn->GetMovementComponent();
+	if (movement != NULL)
+	{
+		movement->StopMovementImmediately();
+		movement->SetComponentTickEnabled(false);
+	}
+
+	// Input is added when the controller ticks, walk after it
+	if (pawn->GetController() != NULL)
+	{
+		PrimaryComponentTick.AddPrerequisite(pawn->GetController(), pawn->GetController()->PrimaryActorTick);
+	}
+
+	// Input left over from before is not meant for the walk
+	pawn->ConsumeMovementInputVector();
+	velocity = FVector::ZeroVector;
+
+	const UCapsuleComponent *capsule = Cast<UCapsuleComponent>(pawn->GetRootComponent());
+	const float halfHeight = capsule != NULL ? capsule->GetScaledCapsuleHalfHeight() : 0.0f;
+	if (!findFloor(pawn->GetActorLocation() - FVector(0.0f, 0.0f, halfHeight), currentFloorHeight))
+	{
+		currentFloorHeight = NoFloor;
+	}
+
+	walking = true;
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+void UKinematicWalker::stopWalking()
+{
+	if (!walking)
+	{
+		return;
+	}
+
+	walking = false;
+	velocity = FVector::ZeroVector;
+	SetComponentTickEnabled(false);
+
+	APawn *pawn = Cast<APawn>(GetOwner());
+	UPawnMovementComponent *movement = pawn != NULL ? pawn->GetMovementComponent() : NULL;
+	if (movement != NULL)
+	{
+		movement->Velocity = FVector::ZeroVector;
+		movement->SetComponentTickEnabled(true);
+	}
+}
+
+void UKinematicWalker::invalidateFloor()
+{
+	floorHeights.Reset();
+}
+
+void UKinematicWalker::onLevelsChanged(ULevel *level, UWorld *world)
+{
+	if (world == GetWorld())
+	{
+		invalidateFloor();
+	}
+}
+
+// Called every frame while walking
+void UKinematicWalker::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KinematicWalk);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	APawn *pawn = Cast<APawn>(GetOwner());
+	if (pawn == NULL)
+	{
+		return;
+	}
+
+	// The same input the character movement would have used, flattened onto the floor
+	FVector input = pawn->ConsumeMovementInputVector();
+	input.Z = 0.0f;
+	velocity = FMath::VInterpConstantTo(velocity, input.GetClampedToMaxSize(1.0f) * walkSpeed, DeltaTime, acceleration);
+
+	// Animation reads the speed from the movement component
+	if (pawn->GetMovementComponent() != NULL)
+	{
+		pawn->GetMovementComponent()->Velocity = velocity;
+	}
+
+	walk(velocity * DeltaTime, DeltaTime);
+}
+
+void UKinematicWalker::walk(const FVector &delta, float DeltaTime)
+{
+	AActor *owner = GetOwner();
+	const UCapsuleComponent *capsule = Cast<UCapsuleComponent>(owner->GetRootComponent());
+	const float halfHeight = capsule != NULL ? capsule->GetScaledCapsuleHalfHeight() : 0.0f;
+	const FVector location = owner->GetActorLocation();
+
+	FVector target = delta.IsNearlyZero() ? location : slide(location, delta);
+
+	// Too high to step up to or nothing to stand on, the move stops here
+	float floorHeight;
+	if (!findFloor(target - FVector(0.0f, 0.0f, halfHeight), floorHeight) ||
+		(currentFloorHeight != NoFloor && floorHeight - currentFloorHeight > maxStepHeight))
+	{
+		target = location;
+		velocity = FVector::ZeroVector;
+		floorHeight = currentFloorHeight;
+	}
+
+	if (floorHeight != NoFloor)
+	{
+		target.Z = FMath::FInterpTo(location.Z, floorHeight + halfHeight, DeltaTime, floorFollowSpeed);
+		currentFloorHeight = floorHeight;
+	}
+
+	if (!target.Equals(location))
+	{
+		owner->SetActorLocation(target);
+	}
+}
+
+FVector UKinematicWalker::slide(const FVector &start, const FVector &delta) const
+{
+	const UCapsuleComponent *capsule = Cast<UCapsuleComponent>(GetOwner()->GetRootComponent());
+	if (capsule == NULL)
+	{
+		return start + delta;
+	}
+
+	// The swept capsule's bottom is raised by the step height so steps are climbed rather than slid along
+	const float radius = capsule->GetScaledCapsuleRadius();
+	const float halfHeight = FMath::Max(capsule->GetScaledCapsuleHalfHeight() - maxStepHeight * 0.5f, radius);
+	const FVector raise(0.0f, 0.0f, capsule->GetScaledCapsuleHalfHeight() - halfHeight);
+	const FCollisionShape shape = FCollisionShape::MakeCapsule(radius, halfHeight);
+
+	// Simple collision only, the architecture's complex collision is far too detailed to slide along
+	FCollisionQueryParams params(SlideTraceTag, false, GetOwner());
+	FCollisionResponseParams responseParams;
+	capsule->InitSweepCollisionParams(params, responseParams);
+	params.bTraceComplex = false;
+
+	FVector location = start + raise;
+	FVector remaining = delta;
+	for (int32 iteration = 0; iteration < MaxSlides && !remaining.IsNearlyZero(); iteration++)
+	{
+		INC_DWORD_STAT(STAT_WalkSweeps);
+
+		FHitResult hit;
+		if (!GetWorld()->SweepSingleByChannel(hit, location, location + remaining, FQuat::Identity, capsule->GetCollisionObjectType(), shape, params, responseParams))
+		{
+			location += remaining;
+			break;
+		}
+		if (hit.bStartPenetrating)
+		{
+			break;
+		}
+
+		// Stop just short of the hit and carry on along it with what is left
+		location = hit.Location + hit.Normal * SlideSkin;
+		remaining *= 1.0f - hit.Time;
+		const FVector wallNormal = FVector(hit.Normal.X, hit.Normal.Y, 0.0f).GetSafeNormal();
+		remaining -= wallNormal * (remaining | wallNormal);
+	}
+
+	return location - raise;
+}
+
+bool UKinematicWalker::findFloor(const FVector &feet, float &outHeight)
+{
+	// Cells are sampled at their centres, so the four around the feet are interpolated
+	const float cellSize = FMath::Max(floorCellSize, 1.0f);
+	const float cellX = feet.X / cellSize - 0.5f;
+	const float cellY = feet.Y / cellSize - 0.5f;
+	const int32 x = FMath::FloorToInt(cellX);
+	const int32 y = FMath::FloorToInt(cellY);
+	const float alphaX = cellX - x;
+	const float alphaY = cellY - y;
+	const int32 band = FMath::FloorToInt(feet.Z / FMath::Max(maxStepHeight, 1.0f));
+
+	const float height00 = getCellHeight(x, y, band);
+	const float height10 = getCellHeight(x + 1, y, band);
+	const float height01 = getCellHeight(x, y + 1, band);
+	const float height11 = getCellHeight(x + 1, y + 1, band);
+
+	// Across a ledge or the edge of the floor the nearest cell is used as is
+	const float lowest = FMath::Min(FMath::Min(height00, height10), FMath::Min(height01, height11));
+	const float highest = FMath::Max(FMath::Max(height00, height10), FMath::Max(height01, height11));
+	if (lowest != NoFloor && highest - lowest <= maxStepHeight)
+	{
+		outHeight = FMath::BiLerp(height00, height10, height01, height11, alphaX, alphaY);
+		return true;
+	}
+
+	const float heights[4] = { height00, height10, height01, height11 };
+	outHeight = heights[(alphaX >= 0.5f ? 1 : 0) + (alphaY >= 0.5f ? 2 : 0)];
+	return outHeight != NoFloor;
+}
+
+float UKinematicWalker::getCellHeight(int32 cellX, int32 cellY, int32 band)
+{
+	const uint64 key = makeFloorKey(cellX, cellY, band);
+	const float *cachedHeight = floorHeights.Find(key);
+	if (cachedHeight != NULL)
+	{
+		return *cachedHeight;
+	}
+
+	if (floorHeights.Num() >= maxFloorCells)
+	{
+		floorHeights.Reset();
+	}
+
+	// One trace per cell and band, from a step above the band down to the furthest drop
+	const float bandHeight = FMath::Max(maxStepHeight, 1.0f);
+	const float cellSize = FMath::Max(floorCellSize, 1.0f);
+	const FVector center((cellX + 0.5f) * cellSize, (cellY + 0.5f) * cellSize, (band + 1) * bandHeight + maxStepHeight);
+	const FVector end(center.X, center.Y, band * bandHeight - maxDropHeight);
+
+	FCollisionQueryParams params(FloorTraceTag, false, GetOwner());
+	FCollisionResponseParams responseParams;
+	ECollisionChannel channel = ECC_Pawn;
+	const UCapsuleComponent *capsule = Cast<UCapsuleComponent>(GetOwner()->GetRootComponent());
+	if (capsule != NULL)
+	{
+		capsule->InitSweepCollisionParams(params, responseParams);
+		params.bTraceComplex = false;
+		channel = capsule->GetCollisionObjectType();
+	}
+
+	INC_DWORD_STAT(STAT_FloorTraces);
+
+	float height = NoFloor;
+	FHitResult hit;
+	if (GetWorld()->LineTraceSingleByChannel(hit, center, end, channel, params, responseParams) && hit.ImpactNormal.Z >= WalkableNormalZ)
+	{
+		height = hit.ImpactPoint.Z;
+	}
+
+	floorHeights.Add(key, height);
+	return height;
+}
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "KinematicWalker.generated.h"
+
+/**
+ * Walks the owning pawn without the character movement pipeline. The pawn's movement input,
+ * from MoveForward and MoveRight, is consumed directly, the capsule is swept against simple
+ * collision only and slides along whatever it hits, and the feet are put on the floor read from
+ * a height field cached in cells, each filled by one downward trace the first time it is
+ * walked over. Steps up to maxStepHeight are climbed, anything higher or without a floor stops
+ * the move. While walking the character movement component doesn't tick at all. Ticks only while
+ * walking, and only when enabled, otherwise the character movement component walks as before.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UKinematicWalker : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UKinematicWalker();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame while walking
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Take over the owner's movement, returns false if disabled so the character movement walks instead
+	bool startWalking();
+
+	// Hand the owner's movement back to the character movement component
+	void stopWalking();
+
+	// Whether the owner is being walked
+	bool isWalking() const { return walking; }
+
+	// Forget the cached floor, for when the geometry under it has changed
+	void invalidateFloor();
+
+	// Walk kinematically instead of with the character movement component
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	bool enabled;
+
+	// Top walking speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float walkSpeed;
+
+	// Rate the walking speed changes at
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float acceleration;
+
+	// Highest step the walk climbs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float maxStepHeight;
+
+	// Furthest the floor is looked for below the feet
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float maxDropHeight;
+
+	// How quickly the feet follow the floor up and down steps
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float floorFollowSpeed;
+
+	// Size of a height field cell
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	float floorCellSize;
+
+	// Cells cached before the height field is cleared
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Movement)
+	int32 maxFloorCells;
+
+private:
+	// Move the owner by the horizontal delta, sliding along what it hits, and put it on the floor
+	void walk(const FVector &delta, float DeltaTime);
+
+	// Sweep the capsule along the delta, sliding along what it hits, returns where it ends
+	FVector slide(const FVector &start, const FVector &delta) const;
+
+	// Height of the floor under a point, false if there is none within reach
+	bool findFloor(const FVector &feet, float &outHeight);
+
+	// Floor height of a height field cell, NoFloor if there is none
+	float getCellHeight(int32 cellX, int32 cellY, int32 band);
+
+	// Drop the height field when a level streams in or out
+	void onLevelsChanged(ULevel *level, UWorld *world);
+
+	bool walking;
+	FVector velocity;
+
+	// Floor the feet were last put on
+	float currentFloorHeight;
+
+	/** Floor height of each cell, keyed by cell and the height band of the feet */
+	TMap<uint64, float> floorHeights;
+
+	FDelegateHandle levelAddedHandle;
+	FDelegateHandle levelRemovedHandle;
+};
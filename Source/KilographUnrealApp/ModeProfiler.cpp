@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "ModeProfiler.h"
+#include "RHI.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Frame Ms"), STAT_ModeFrameMs, STATGROUP_KilographModes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Draw Calls"), STAT_ModeDrawCalls, STATGROUP_KilographModes);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Resident Memory MB"), STAT_ModeMemoryMB, STATGROUP_KilographModes);
+
+const float FModeProfiler::FrameTimeBucketEdges[FModeProfiler::NumFrameTimeBuckets - 1] = { 8.3f, 16.7f, 33.3f, 50.0f, 100.0f };
+
+// How often resident memory is queried
+static const float MemorySampleInterval = 0.5f;
+
+FModeProfiler::FModeProfiler(int32 windowSizeInput)
+	: windowSize(FMath::Max(windowSizeInput, 1))
+	, memoryMB(0.0f)
+	, memorySampleAge(MemorySampleInterval)
+{
+}
+
+void FModeProfiler::sampleFrame(const TCHAR *modeName, float DeltaSeconds)
+{
+	memorySampleAge += DeltaSeconds;
+	if (memorySampleAge >= MemorySampleInterval)
+	{
+		memoryMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0f * 1024.0f);
+		memorySampleAge = 0.0f;
+	}
+
+	// The draw call count is the render thread's total for the last frame it finished
+	const float frameMs = DeltaSeconds * 1000.0f;
+	const int32 drawCalls = GNumDrawCallsRHI;
+	addFrame(modeName, frameMs, drawCalls, memoryMB);
+
+	SET_FLOAT_STAT(STAT_ModeFrameMs, frameMs);
+	SET_DWORD_STAT(STAT_ModeDrawCalls, drawCalls);
+	SET_FLOAT_STAT(STAT_ModeMemoryMB, memoryMB);
+}
+
+void FModeProfiler::addFrame(const TCHAR *modeName, float frameMs, int32 drawCalls, float memoryMBInput)
+{
+	FModeWindow *window = modes.Find(modeName);
+	if (window == NULL)
+	{
+		modeNames.Add(modeName);
+		window = &modes.Add(modeName, FModeWindow());
+		window->samples.Reserve(windowSize);
+	}
+
+	FSample sample;
+	sample.frameMs = frameMs;
+	sample.drawCalls = drawCalls;
+	sample.memoryMB = memoryMBInput;
+
+	// Fill the window first, then overwrite the oldest frame
+	if (window->samples.Num() < windowSize)
+	{
+		window->samples.Add(sample);
+	}
+	else
+	{
+		window->samples[window->next] = sample;
+	}
+	window->next = (window->next + 1) % windowSize;
+}
+
+void FModeProfiler::reset()
+{
+	modeNames.Reset();
+	modes.Reset();
+}
+
+int32 FModeProfiler::findBucket(float frameMs)
+{
+	for (int32 bucket = 0; bucket < NumFrameTimeBuckets - 1; bucket++)
+	{
+		if (frameMs <= FrameTimeBucketEdges[bucket])
+		{
+			return bucket;
+		}
+	}
+	return NumFrameTimeBuckets - 1;
+}
+
+FString FModeProfiler::getBucketLabel(int32 bucket)
+{
+	if (bucket == NumFrameTimeBuckets - 1)
+	{
+		return FString::Printf(TEXT(">%.1f"), FrameTimeBucketEdges[bucket - 1]);
+	}
+	return FString::Printf(TEXT("%.1f-%.1f"), bucket > 0 ? FrameTimeBucketEdges[bucket - 1] : 0.0f, FrameTimeBucketEdges[bucket]);
+}
+
+bool FModeProfiler::summarize(const FString &modeName, FSummary &outSummary) const
+{
+	const FModeWindow *window = modes.Find(modeName);
+	if (window == NULL || window->samples.Num() == 0)
+	{
+		return false;
+	}
+
+	FMemory::Memzero(outSummary);
+	outSummary.frames = window->samples.Num();
+
+	TArray<float> frameTimes;
+	frameTimes.Reserve(window->samples.Num());
+	double totalFrameMs = 0.0;
+	double totalDrawCalls = 0.0;
+	double totalMemoryMB = 0.0;
+	for (int32 sampleIndex = 0; sampleIndex < window->samples.Num(); sampleIndex++)
+	{
+		const FSample &sample = window->samples[sampleIndex];
+		frameTimes.Add(sample.frameMs);
+		totalFrameMs += sample.frameMs;
+		totalDrawCalls += sample.drawCalls;
+		totalMemoryMB += sample.memoryMB;
+		outSummary.maxFrameMs = FMath::Max(outSummary.maxFrameMs, sample.frameMs);
+		outSummary.maxDrawCalls = FMath::Max(outSummary.maxDrawCalls, sample.drawCalls);
+		outSummary.maxMemoryMB = FMath::Max(outSummary.maxMemoryMB, sample.memoryMB);
+		outSummary.frameTimeBuckets[findBucket(sample.frameMs)]++;
+	}
+
+	frameTimes.Sort();
+	outSummary.p95FrameMs = frameTimes[FMath::Min(FMath::FloorToInt(frameTimes.Num() * 0.95f), frameTimes.Num() - 1)];
+	outSummary.averageFrameMs = totalFrameMs / outSummary.frames;
+	outSummary.averageDrawCalls = totalDrawCalls / outSummary.frames;
+	outSummary.averageMemoryMB = totalMemoryMB / outSummary.frames;
+	return true;
+}
+
+bool FModeProfiler::writeCsv(const FString &path) const
+{
+	FString output = TEXT("mode,frames,avgFrameMs,p95FrameMs,maxFrameMs,avgDrawCalls,maxDrawCalls,avgMemoryMB,maxMemoryMB");
+	for (int32 bucket = 0; bucket < NumFrameTimeBuckets; bucket++)
+	{
+		output += FString::Printf(TEXT(",frames%sMs"), *getBucketLabel(bucket));
+	}
+	output += LINE_TERMINATOR;
+
+	for (int32 modeIndex = 0; modeIndex < modeNames.Num(); modeIndex++)
+	{
+		FSummary summary;
+		if (!summarize(modeNames[modeIndex], summary))
+		{
+			continue;
+		}
+
+		output += FString::Printf(TEXT("%s,%d,%.3f,%.3f,%.3f,%.1f,%d,%.1f,%.1f"), *modeNames[modeIndex], summary.frames,
+			summary.averageFrameMs, summary.p95FrameMs, summary.maxFrameMs, summary.averageDrawCalls, summary.maxDrawCalls,
+			summary.averageMemoryMB, summary.maxMemoryMB);
+		for (int32 bucket = 0; bucket < NumFrameTimeBuckets; bucket++)
+		{
+			output += FString::Printf(TEXT(",%d"), summary.frameTimeBuckets[bucket]);
+		}
+		output += LINE_TERMINATOR;
+	}
+
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to write mode stats to %s"), *path);
+		return false;
+	}
+
+	UE_LOG(Kilograph, Log, TEXT("Wrote mode stats to %s"), *path);
+	return true;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Rolling per-mode cost tracking. Each mode keeps a window of its most recent frames with their
+ * frame time, draw calls and resident memory, and a histogram of the frame times in the window,
+ * so a session can show which mode goes over budget. The window can be exported as CSV.
+ */
+class KILOGRAPHUNREALAPP_API FModeProfiler
+{
+public:
+	// Upper edges of the frame time histogram buckets in ms, the last bucket takes everything slower
+	static const int32 NumFrameTimeBuckets = 6;
+	static const float FrameTimeBucketEdges[NumFrameTimeBuckets - 1];
+
+	// Costs of a mode over its window
+	struct FSummary
+	{
+		int32 frames;
+		float averageFrameMs;
+		float p95FrameMs;
+		float maxFrameMs;
+		float averageDrawCalls;
+		int32 maxDrawCalls;
+		float averageMemoryMB;
+		float maxMemoryMB;
+		int32 frameTimeBuckets[NumFrameTimeBuckets];
+	};
+
+	FModeProfiler(int32 windowSizeInput = 600);
+
+	// Gather the costs of the frame that just finished and account them to the given mode
+	void sampleFrame(const TCHAR *modeName, float DeltaSeconds);
+
+	// Account a frame to the given mode
+	void addFrame(const TCHAR *modeName, float frameMs, int32 drawCalls, float memoryMBInput);
+
+	// Forget every recorded frame
+	void reset();
+
+	// Names of the modes with frames recorded, in the order they were first seen
+	const TArray<FString> &getModeNames() const { return modeNames; }
+
+	// Summarize a mode's window, returns false if the mode has no frames
+	bool summarize(const FString &modeName, FSummary &outSummary) const;
+
+	// Write the summary of every mode to a CSV file
+	bool writeCsv(const FString &path) const;
+
+	// Label of a histogram bucket, such as "16.7-33.3"
+	static FString getBucketLabel(int32 bucket);
+
+private:
+	struct FSample
+	{
+		float frameMs;
+		int32 drawCalls;
+		float memoryMB;
+	};
+
+	// Ring buffer of a mode's most recent frames
+	struct FModeWindow
+	{
+		FModeWindow() : next(0) {}
+
+		TArray<FSample> samples;
+		int32 next;
+	};
+
+	static int32 findBucket(float frameMs);
+
+	int32 windowSize;
+	TArray<FString> modeNames;
+	TMap<FString, FModeWindow> modes;
+
+	// Resident memory is expensive to query on some platforms, so it is only refreshed a few times a second
+	float memoryMB;
+	float memorySampleAge;
+};
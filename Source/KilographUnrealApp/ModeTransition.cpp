@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "ModeTransition.h"
+#include "StartupLoader.h"
+#include "VisibilityGroups.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mode Transition Commit"), STAT_ModeTransitionCommit, STATGROUP_Kilograph);
+
+// Sets default values for this component's properties
+UModeTransition::UModeTransition()
+{
+	// Only ticks while a transition is running, and moves the owner so runs before physics
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	blendTime = 0.4f;
+	maxWarmupTime = 3.0f;
+	transitioning = false;
+	resourcesLoaded = true;
+	elapsed = 0.0f;
+	requestId = 0;
+}
+
+void UModeTransition::begin(const FModeResources &resources, const FVector &targetLocationInput, const FRotator &targetRotationInput)
+{
+	AActor *owner = GetOwner();
+	APawn *pawn = Cast<APawn>(owner);
+	startLocation = owner->GetActorLocation();
+	startRotation = pawn != NULL && pawn->GetController() != NULL ? pawn->GetController()->GetControlRotation() : owner->GetActorRotation();
+	targetLocation = targetLocationInput;
+	targetRotation = targetRotationInput;
+	elapsed = 0.0f;
+	transitioning = true;
+	SetComponentTickEnabled(true);
+
+	// Resolve the visibility groups now so the commit only flips visibility
+	UVisibilityGroups *visibilityGroups = owner->FindComponentByClass<UVisibilityGroups>();
+	if (visibilityGroups != NULL)
+	{
+		for (int32 groupIndex = 0; groupIndex < resources.visibilityGroups.Num(); groupIndex++)
+		{
+			visibilityGroups->warmGroup(resources.visibilityGroups[groupIndex]);
+		}
+	}
+
+	pendingAssets.Reset();
+	for (int32 assetIndex = 0; assetIndex < resources.assets.Num(); assetIndex++)
+	{
+		if (!resources.assets[assetIndex].IsNull())
+		{
+			pendingAssets.Add(resources.assets[assetIndex].ToStringReference());
+		}
+	}
+
+	requestId++;
+	UStartupLoader *loader = UStartupLoader::get(this);
+	if (pendingAssets.Num() == 0 || loader == NULL)
+	{
+		resourcesLoaded = true;
+		return;
+	}
+
+	resourcesLoaded = false;
+	loader->getStreamableManager().RequestAsyncLoad(pendingAssets, FStreamableDelegate::CreateUObject(this, &UModeTransition::onResourcesLoaded, requestId));
+}
+
+void UModeTransition::onResourcesLoaded(int32 loadedRequestId)
+{
+	if (loadedRequestId != requestId)
+	{
+		return;
+	}
+
+	// Hold on to the new mode's assets, the previous mode's are released to the garbage collector
+	residentAssets.Reset();
+	for (int32 assetIndex = 0; assetIndex < pendingAssets.Num(); assetIndex++)
+	{
+		UObject *asset = pendingAssets[assetIndex].ResolveObject();
+		if (asset != NULL)
+		{
+			residentAssets.Add(asset);
+		}
+	}
+	resourcesLoaded = true;
+}
+
+// Called every frame while a transition is running
+void UModeTransition::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	elapsed += DeltaTime;
+	const float alpha = blendTime > 0.0f ? FMath::Clamp(elapsed / blendTime, 0.0f, 1.0f) : 1.0f;
+	const float blend = FMath::InterpEaseInOut(0.0f, 1.0f, alpha, 2.0f);
+
+	AActor *owner = GetOwner();
+	owner->SetActorLocation(FMath::Lerp(startLocation, targetLocation, blend));
+	APawn *pawn = Cast<APawn>(owner);
+	if (pawn != NULL && pawn->GetController() != NULL)
+	{
+		pawn->GetController()->SetControlRotation(FMath::Lerp(startRotation, targetRotation, blend));
+	}
+
+	// Hold the view at the mode's start until its resources are in, unless they take too long
+	if (alpha >= 1.0f && (resourcesLoaded || elapsed >= blendTime + maxWarmupTime))
+	{
+		if (!resourcesLoaded)
+		{
+			UE_LOG(Kilograph, Warning, TEXT("Mode transition committed before its resources were resident"));
+		}
+		commit();
+	}
+}
+
+void UModeTransition::commit()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ModeTransitionCommit);
+
+	transitioning = false;
+	SetComponentTickEnabled(false);
+	onCommit.ExecuteIfBound();
+}
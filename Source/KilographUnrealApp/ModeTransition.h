@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "ModeTransition.generated.h"
+
+DECLARE_DELEGATE(FModeTransitionCommitSignature);
+
+// Content a mode needs resident before it can take over
+USTRUCT(BlueprintType)
+struct FModeResources
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Assets streamed in before the mode commits
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	TArray<TAssetPtr<UObject> > assets;
+
+	// Visibility groups of the owner resolved before the mode commits
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	TArray<FName> visibilityGroups;
+};
+
+/**
+ * Moves the owner into a new mode over a short blend instead of in a single frame. The mode's
+ * resources are warmed while the view eases from where it is to where the mode starts, and the
+ * switch is only committed once the blend has finished and the resources are resident.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UModeTransition : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UModeTransition();
+
+	// Called every frame while a transition is running
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Start moving to a mode that begins at the given view, replacing any transition in progress
+	void begin(const FModeResources &resources, const FVector &targetLocation, const FRotator &targetRotation);
+
+	// Whether a transition is running
+	bool isTransitioning() const { return transitioning; }
+
+	// Time the view takes to blend to the new mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	float blendTime;
+
+	// Longest the transition waits on resources after the blend before committing anyway
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Transition)
+	float maxWarmupTime;
+
+	// Called when the new mode should take over
+	FModeTransitionCommitSignature onCommit;
+
+private:
+	// Called when the assets of a transition are resident, stale requests are ignored
+	void onResourcesLoaded(int32 requestId);
+
+	// Finish the transition and hand over to the new mode
+	void commit();
+
+	bool transitioning;
+	bool resourcesLoaded;
+	float elapsed;
+
+	// Id of the latest asset request, bumped by every transition
+	int32 requestId;
+
+	FVector startLocation;
+	FRotator startRotation;
+	FVector targetLocation;
+	FRotator targetRotation;
+
+	// Assets of the latest transition being streamed in
+	TArray<FStringAssetReference> pendingAssets;
+
+	/** Keeps the resources of the current mode from being garbage collected */
+	UPROPERTY()
+	TArray<UObject *> residentAssets;
+};
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "OrbitCamera.h"
+
+DECLARE_CYCLE_STAT(TEXT("Orbit Clearance Probe"), STAT_OrbitClearanceProbe, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Orbit Cached Clearances"), STAT_OrbitCachedClearances, STATGROUP_Kilograph);
+
+// Radii probed per angle bin, from the full orbit distance inwards
+static const int32 ClearanceSteps = 16;
+
+// Sets default values for this component's properties
+UOrbitCamera::UOrbitCamera()
+{
+	// Only moves when the orbit is dragged, never ticks
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = false;
+
+	probeRadius = 20.0f;
+	cacheResolution = 2.0f;
+	orbiting = false;
+	target = FVector::ZeroVector;
+	distance = 0.0f;
+	cachedXRotation = 0.0f;
+	cachedZRotation = 0.0f;
+	sinX = 0.0f;
+	cosX = 1.0f;
+	sinZ = 0.0f;
+	cosZ = 1.0f;
+	cameraLocation = FVector::ZeroVector;
+	cameraRotation = FRotator::ZeroRotator;
+}
+
+// Called when the game starts
+void UOrbitCamera::BeginPlay()
+{
+	Super::BeginPlay();
+
+	levelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UOrbitCamera::onLevelsChanged);
+	levelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UOrbitCamera::onLevelsChanged);
+}
+
+// Called when the component is removed from play
+void UOrbitCamera::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(levelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(levelRemovedHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Rolling by x then yawing by z carries the unit y axis to (-cos x sin z, cos x cos z, -sin x)
+FVector UOrbitCamera::computeOffset(float xRotation, float zRotation, float orbitDistance)
+{
+	float sinXRotation, cosXRotation, sinZRotation, cosZRotation;
+	FMath::SinCos(&sinXRotation, &cosXRotation, FMath::DegreesToRadians(xRotation));
+	FMath::SinCos(&sinZRotation, &cosZRotation, FMath::DegreesToRadians(zRotation));
+	return FVector(-cosXRotation * sinZRotation, cosXRotation * cosZRotation, -sinXRotation) * orbitDistance;
+}
+
+void UOrbitCamera::startOrbit(const FVector &targetInput, float distanceInput)
+{
+	if (!target.Equals(targetInput) || distance != distanceInput)
+	{
+		invalidateClearances();
+	}
+
+	target = targetInput;
+	distance = distanceInput;
+	orbiting = true;
+
+	// Force the trig to be refreshed on the first update
+	cachedXRotation = BIG_NUMBER;
+}
+
+void UOrbitCamera::stopOrbit()
+{
+	orbiting = false;
+}
+
+void UOrbitCamera::invalidateClearances()
+{
+	clearDistanceCache.Reset();
+	SET_DWORD_STAT(STAT_OrbitCachedClearances, 0);
+}
+
+void UOrbitCamera::onLevelsChanged(ULevel *level, UWorld *world)
+{
+	if (world == GetWorld())
+	{
+		invalidateClearances();
+	}
+}
+
+void UOrbitCamera::setAngles(float xRotation, float zRotation)
+{
+	if (xRotation != cachedXRotation)
+	{
+		FMath::SinCos(&sinX, &cosX, FMath::DegreesToRadians(xRotation));
+		cachedXRotation = xRotation;
+	}
+	if (zRotation != cachedZRotation)
+	{
+		FMath::SinCos(&sinZ, &cosZ, FMath::DegreesToRadians(zRotation));
+		cachedZRotation = zRotation;
+	}
+
+	const FVector direction(-cosX * sinZ, cosX * cosZ, -sinX);
+	cameraLocation = target + direction * findClearDistance(direction, xRotation, zRotation);
+
+	// Looking back along the direction is a pitch of x and a yaw of z - 90 while x stays within +-90
+	cameraRotation = FRotator(xRotation, zRotation - 90.0f, 0.0f);
+}
+
+float UOrbitCamera::findClearDistance(const FVector &direction, float xRotation, float zRotation)
+{
+	if (probeRadius <= 0.0f)
+	{
+		return distance;
+	}
+
+	const float resolution = FMath::Max(cacheResolution, 0.1f);
+	// Pitch is offset by a half turn so both bins are positive and each gets its own half of the key
+	const uint32 xBin = (uint32)FMath::Max(FMath::FloorToInt((xRotation + 180.0f) / resolution), 0);
+	const uint32 zBin = (uint32)FMath::FloorToInt(FRotator::ClampAxis(zRotation) / resolution);
+	const uint64 key = ((uint64)xBin << 32) | zBin;
+	const float *cached = clearDistanceCache.Find(key);
+	if (cached != NULL)
+	{
+		return *cached;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OrbitClearanceProbe);
+
+	// Step in from the full radius until the camera sphere is clear of geometry. The target usually sits
+	// inside the building being orbited, so a sweep out from it would stop straight away.
+	FCollisionQueryParams traceParams(FName(TEXT("OrbitCamera")), false, GetOwner());
+	const FCollisionShape sphere = FCollisionShape::MakeSphere(probeRadius);
+	// With every probe blocked the innermost one is used, the closest the camera gets to the target
+	float clearDistance = distance / ClearanceSteps;
+	for (int32 step = 0; step < ClearanceSteps; step++)
+	{
+		const float candidate = distance * (ClearanceSteps - step) / ClearanceSteps;
+		if (!GetWorld()->OverlapBlockingTestByChannel(target + direction * candidate, FQuat::Identity, ECC_Camera, sphere, traceParams))
+		{
+			clearDistance = candidate;
+			break;
+		}
+	}
+
+	clearDistanceCache.Add(key, clearDistance);
+	INC_DWORD_STAT(STAT_OrbitCachedClearances);
+	return clearDistance;
+}
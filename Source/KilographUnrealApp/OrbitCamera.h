@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "OrbitCamera.generated.h"
+
+/**
+ * View orbiting a target on a sphere. The angles' sines and cosines are cached so the camera
+ * location and look at rotation are computed directly rather than through rotators and matrices,
+ * and the orbit radius is pulled in out of occluders using a cache of sphere probes binned by
+ * angle. The view is handed to the camera manager, the owner itself is not moved while orbiting.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UOrbitCamera : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UOrbitCamera();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Start orbiting a target at the given distance, forgetting the radius cache if the orbit changed
+	void startOrbit(const FVector &targetInput, float distanceInput);
+
+	// Stop providing the view
+	void stopOrbit();
+
+	// Whether the orbit currently provides the view
+	bool isOrbiting() const { return orbiting; }
+
+	// Forget the cached clearances, for when the geometry around the orbit has changed
+	void invalidateClearances();
+
+	// Move the camera to the given rotations around the target, in degrees
+	void setAngles(float xRotation, float zRotation);
+
+	// Location of the camera on the orbit
+	const FVector &getCameraLocation() const { return cameraLocation; }
+
+	// Rotation of the camera looking at the target
+	const FRotator &getCameraRotation() const { return cameraRotation; }
+
+	// Offset from the target of a camera orbiting at the given rotations and distance, ignoring occluders
+	static FVector computeOffset(float xRotation, float zRotation, float orbitDistance);
+
+	// Radius of the sphere kept clear of geometry around the camera, 0 ignores occluders
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Orbit)
+	float probeRadius;
+
+	// Size in degrees of the angle bins sharing one cached clearance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Orbit)
+	float cacheResolution;
+
+private:
+	// Furthest distance up to the orbit's along a direction where the camera is clear of geometry, the innermost probe if none is, from the cache or new probes
+	float findClearDistance(const FVector &direction, float xRotation, float zRotation);
+
+	// Drop the cached clearances when a level streams in or out
+	void onLevelsChanged(ULevel *level, UWorld *world);
+
+	bool orbiting;
+	FVector target;
+	float distance;
+
+	/** Angles and their trig from the last update, only recomputed when the angles change */
+	float cachedXRotation;
+	float cachedZRotation;
+	float sinX;
+	float cosX;
+	float sinZ;
+	float cosZ;
+
+	FVector cameraLocation;
+	FRotator cameraRotation;
+
+	// Clear distance found for each angle bin of the current orbit, keyed by the pitch bin in the high half and the yaw bin in the low
+	TMap<uint64, float> clearDistanceCache;
+
+	FDelegateHandle levelAddedHandle;
+	FDelegateHandle levelRemovedHandle;
+};
@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "OrbitProxy.h"
+#include "PrecomputedVisibility.h"
+#include "OrbitCamera.h"
+#include "EngineUtils.h"
+
+DECLARE_CYCLE_STAT(TEXT("Orbit Proxy Swap"), STAT_OrbitProxySwap, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Orbit Swapped Actors"), STAT_OrbitSwappedActors, STATGROUP_Kilograph);
+
+// Actors restored between checks of the frame's time budget
+static const int32 ActorsPerBudgetCheck = 8;
+
+// Sets default values for this component's properties
+UOrbitProxy::UOrbitProxy()
+{
+	// Only ticks while the detail is being swapped back
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	exteriorProxy = NULL;
+	interiorVolume = NULL;
+	swapBackBudgetMs = 1.0f;
+	classified = false;
+	nextSwapBack = 0;
+}
+
+// Called when the game starts
+void UOrbitProxy::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (exteriorProxy != NULL)
+	{
+		exteriorProxy->SetActorHiddenInGame(true);
+	}
+
+	levelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UOrbitProxy::onLevelsChanged);
+	levelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UOrbitProxy::onLevelsChanged);
+}
+
+// Called when the component is removed from play
+void UOrbitProxy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(levelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(levelRemovedHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame while the detail is being swapped back
+void UOrbitProxy::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (swapBack(FPlatformTime::Seconds() + swapBackBudgetMs * 0.001))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UOrbitProxy::enterOrbit()
+{
+	SCOPE_CYCLE_COUNTER(STAT_OrbitProxySwap);
+
+	// Returning to the orbit before the detail is all back, finish the swap back first, it releases the held table actors
+	if (swapped.Num() > 0)
+	{
+		swapBack(0.0);
+		SetComponentTickEnabled(false);
+	}
+
+	if (!classified)
+	{
+		classifyActors();
+	}
+
+	UPrecomputedVisibility *visibility = GetOwner()->FindComponentByClass<UPrecomputedVisibility>();
+	if (visibility != NULL)
+	{
+		visibility->holdActors(tableActors, true);
+	}
+
+	TArray<AActor *> actorsToSwap;
+	for (int32 index = 0; index < tableActors.Num(); index++)
+	{
+		actorsToSwap.Add(visibility != NULL ? visibility->getActor(tableActors[index]) : NULL);
+	}
+	for (int32 index = 0; index < volumeActors.Num(); index++)
+	{
+		actorsToSwap.Add(volumeActors[index].Get());
+	}
+
+	for (int32 index = 0; index < actorsToSwap.Num(); index++)
+	{
+		AActor *actor = actorsToSwap[index];
+		if (actor == NULL)
+		{
+			continue;
+		}
+
+		FSwappedActor &entry = swapped[swapped.AddDefaulted()];
+		entry.actor = actor;
+		entry.wasHidden = actor->bHidden;
+		entry.wasTicking = actor->IsActorTickEnabled();
+		entry.firstComponent = swappedComponents.Num();
+
+		TInlineComponentArray<UActorComponent*> components(actor);
+		for (int32 componentIndex = 0; componentIndex < components.Num(); componentIndex++)
+		{
+			if (components[componentIndex]->IsComponentTickEnabled())
+			{
+				components[componentIndex]->SetComponentTickEnabled(false);
+				swappedComponents.Add(components[componentIndex]);
+			}
+		}
+		entry.numComponents = swappedComponents.Num() - entry.firstComponent;
+
+		actor->SetActorHiddenInGame(true);
+		actor->SetActorTickEnabled(false);
+	}
+	nextSwapBack = 0;
+	INC_DWORD_STAT_BY(STAT_OrbitSwappedActors, swapped.Num());
+
+	if (exteriorProxy != NULL)
+	{
+		exteriorProxy->SetActorHiddenInGame(false);
+		invalidateOrbitClearances();
+	}
+}
+
+void UOrbitProxy::leaveOrbit()
+{
+	if (swapped.Num() > 0)
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UOrbitProxy::classifyActors()
+{
+	classified = true;
+	tableActors.Reset();
+	volumeActors.Reset();
+
+	// With a proxy standing in for the exterior, every actor of the table goes
+	TSet<AActor *> tableActorSet;
+	UPrecomputedVisibility *visibility = GetOwner()->FindComponentByClass<UPrecomputedVisibility>();
+	if (visibility != NULL && visibility->hasTable())
+	{
+		visibility->findOrbitHiddenActors(exteriorProxy != NULL, tableActors);
+		for (int32 index = 0; index < tableActors.Num(); index++)
+		{
+			tableActorSet.Add(visibility->getActor(tableActors[index]));
+		}
+	}
+
+	// Lights, furniture and anything else inside that the table doesn't cover
+	if (interiorVolume != NULL)
+	{
+		const FBox interiorBounds = interiorVolume->GetComponentsBoundingBox(true);
+		for (TActorIterator<AActor> actorIt(GetWorld()); actorIt; ++actorIt)
+		{
+			if (!tableActorSet.Contains(*actorIt) && isSwappable(*actorIt) && interiorBounds.IsInside(actorIt->GetActorLocation()))
+			{
+				volumeActors.Add(*actorIt);
+			}
+		}
+	}
+
+	UE_LOG(Kilograph, Log, TEXT("Orbit swaps out %d table actors and %d interior actors"), tableActors.Num(), volumeActors.Num());
+}
+
+void UOrbitProxy::onLevelsChanged(ULevel *level, UWorld *world)
+{
+	// Swapped actors are restored through their own entries, only the next swap uses the new classification
+	if (world == GetWorld())
+	{
+		classified = false;
+	}
+}
+
+bool UOrbitProxy::coversActor(const AActor *actor) const
+{
+	// The table's own actors are covered by the precomputed visibility, this is everything else the orbit hides
+	return interiorVolume != NULL && isSwappable(actor) &&
+		interiorVolume->GetComponentsBoundingBox(true).IsInside(actor->GetActorLocation());
+}
+
+bool UOrbitProxy::isSwappable(const AActor *actor) const
+{
+	// Players, controllers, managers and the swap's own actors keep running
+	return actor != GetOwner() &&
+		actor != exteriorProxy &&
+		actor != interiorVolume &&
+		actor->GetRootComponent() != NULL &&
+		!actor->IsA<APawn>() &&
+		!actor->IsA<AController>() &&
+		!actor->IsA<AInfo>() &&
+		!actor->IsA<APlayerCameraManager>() &&
+		!actor->IsA<AHUD>();
+}
+
+bool UOrbitProxy::swapBack(double deadline)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OrbitProxySwap);
+
+	while (nextSwapBack < swapped.Num())
+	{
+		const FSwappedActor &entry = swapped[nextSwapBack];
+		nextSwapBack++;
+
+		AActor *actor = entry.actor.Get();
+		if (actor != NULL)
+		{
+			actor->SetActorHiddenInGame(entry.wasHidden);
+			actor->SetActorTickEnabled(entry.wasTicking);
+		}
+		for (int32 componentIndex = entry.firstComponent; componentIndex < entry.firstComponent + entry.numComponents; componentIndex++)
+		{
+			UActorComponent *component = swappedComponents[componentIndex].Get();
+			if (component != NULL)
+			{
+				component->SetComponentTickEnabled(true);
+			}
+		}
+
+		if (deadline > 0.0 && nextSwapBack < swapped.Num() && nextSwapBack % ActorsPerBudgetCheck == 0 && FPlatformTime::Seconds() >= deadline)
+		{
+			return false;
+		}
+	}
+
+	// Everything is back, the table culls its actors again and the proxy goes
+	UPrecomputedVisibility *visibility = GetOwner()->FindComponentByClass<UPrecomputedVisibility>();
+	if (visibility != NULL)
+	{
+		visibility->holdActors(tableActors, false);
+	}
+	if (exteriorProxy != NULL)
+	{
+		exteriorProxy->SetActorHiddenInGame(true);
+		invalidateOrbitClearances();
+	}
+
+	DEC_DWORD_STAT_BY(STAT_OrbitSwappedActors, swapped.Num());
+	swapped.Reset();
+	swappedComponents.Reset();
+	nextSwapBack = 0;
+	return true;
+}
+
+void UOrbitProxy::invalidateOrbitClearances()
+{
+	// The orbit camera's probes were made against the other set of geometry
+	UOrbitCamera *orbitCamera = GetOwner()->FindComponentByClass<UOrbitCamera>();
+	if (orbitCamera != NULL)
+	{
+		orbitCamera->invalidateClearances();
+	}
+}
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "OrbitProxy.generated.h"
+
+/**
+ * Swaps the building's detail out while the owner orbits it. Interior actors, the ones the baked
+ * visibility table never sees from the orbit shell plus anything else inside the interior volume,
+ * are hidden and stop ticking. When an exterior proxy is set, a merged simplified mesh of the
+ * building, the detailed exterior is hidden as well and the proxy is drawn in its place. The
+ * swap in happens at once when the orbit starts, the swap back is spread over several frames
+ * within a time budget so leaving the orbit doesn't hitch.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UOrbitProxy : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UOrbitProxy();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame while the detail is being swapped back
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Hide the detail and show the proxy
+	void enterOrbit();
+
+	// Start bringing the detail back
+	void leaveOrbit();
+
+	// Whether the actor sits inside the interior volume and is swapped out with it
+	bool coversActor(const AActor *actor) const;
+
+	// Whether the detail is swapped out, or still being swapped back
+	bool isSwapped() const { return swapped.Num() > 0; }
+
+	// Merged, simplified exterior drawn while orbiting, hidden the rest of the time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Orbit)
+	AActor *exteriorProxy;
+
+	// Volume covering the interior, actors inside it are swapped out even if the visibility table doesn't know them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Orbit)
+	AActor *interiorVolume;
+
+	// Time in milliseconds the swap back may spend per frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Orbit)
+	float swapBackBudgetMs;
+
+private:
+	// Actor swapped out and what to restore
+	struct FSwappedActor
+	{
+		TWeakObjectPtr<AActor> actor;
+		bool wasHidden;
+		bool wasTicking;
+		// Components whose tick was switched off, a range of swappedComponents
+		int32 firstComponent;
+		int32 numComponents;
+	};
+
+	// Work out the actors to swap, done on the first orbit once the visibility table is loaded and again after levels stream
+	void classifyActors();
+
+	// Classify the actors again on the next orbit when a level streams in or out
+	void onLevelsChanged(ULevel *level, UWorld *world);
+
+	// Whether an actor inside the interior volume can be swapped out
+	bool isSwappable(const AActor *actor) const;
+
+	// Restore swapped actors until the deadline, returns true once all are back
+	bool swapBack(double deadline);
+
+	// Make the orbit camera probe again after the exterior and its proxy swapped
+	void invalidateOrbitClearances();
+
+	bool classified;
+
+	// Table actors and other actors to swap out
+	TArray<int32> tableActors;
+	TArray<TWeakObjectPtr<AActor> > volumeActors;
+
+	TArray<FSwappedActor> swapped;
+	TArray<TWeakObjectPtr<UActorComponent> > swappedComponents;
+
+	// Next entry of swapped to restore
+	int32 nextSwapBack;
+
+	FDelegateHandle levelAddedHandle;
+	FDelegateHandle levelRemovedHandle;
+};
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "PanoramaAsset.h"
+
+UPanoramaAsset::UPanoramaAsset()
+{
+	tileSize = 512;
+	maxLevel = 2;
+}
+
+int32 UPanoramaAsset::findTile(int32 tileKey) const
+{
+	if (tileIndices.Num() != tiles.Num())
+	{
+		tileIndices.Reset();
+		for (int32 tileIndex = 0; tileIndex < tiles.Num(); tileIndex++)
+		{
+			const FPanoramaTile &tile = tiles[tileIndex];
+			tileIndices.Add(makeTileKey(tile.face, tile.level, tile.x, tile.y), tileIndex);
+		}
+	}
+
+	const int32 *tileIndex = tileIndices.Find(tileKey);
+	return tileIndex != NULL ? *tileIndex : INDEX_NONE;
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "PanoramaAsset.generated.h"
+
+// One tile of a cubemap face at one level of detail
+USTRUCT(BlueprintType)
+struct FPanoramaTile
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Cube face, in the order +X, -X, +Y, -Y, +Z, -Z
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	int32 face;
+
+	// Level of detail, level n splits each face into 2^n by 2^n tiles
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	int32 level;
+
+	// Column of the tile on its face, from the face's left
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	int32 x;
+
+	// Row of the tile on its face, from the face's bottom
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	int32 y;
+
+	// Texture of the tile, streamed in only while the tile is in view
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	TAssetPtr<UTexture2D> texture;
+
+	FPanoramaTile() : face(0), level(0), x(0), y(0) {}
+};
+
+/**
+ * A panorama cut into a quadtree of cubemap tiles per face. Level 0 is the whole face in one
+ * tile and is kept resident while the panorama is shown, finer levels are streamed per tile.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UPanoramaAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPanoramaAsset();
+
+	// Key identifying a tile within a panorama
+	static int32 makeTileKey(int32 face, int32 level, int32 x, int32 y) { return (((face << 4) | level) << 20) | (y << 10) | x; }
+
+	// Index into tiles of the tile with the given key, INDEX_NONE if the panorama does not have it
+	int32 findTile(int32 tileKey) const;
+
+	// Name shown for the panorama
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Panorama)
+	FText displayName;
+
+	// Texels along the edge of every tile
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Panorama)
+	int32 tileSize;
+
+	// Finest level of detail with tiles
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Panorama)
+	int32 maxLevel;
+
+	// Every tile of every level
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Panorama)
+	TArray<FPanoramaTile> tiles;
+
+private:
+	// Tile indices by key, built on first lookup
+	mutable TMap<int32, int32> tileIndices;
+};
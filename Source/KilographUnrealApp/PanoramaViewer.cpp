@@ -0,0 +1,327 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "PanoramaViewer.h"
+#include "PanoramaAsset.h"
+#include "StartupLoader.h"
+
+DECLARE_CYCLE_STAT(TEXT("Panorama Update"), STAT_PanoramaUpdate, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Panorama Resident Tiles"), STAT_PanoramaResidentTiles, STATGROUP_Kilograph);
+
+// Axes of the cube faces seen from the inside, in the order +X, -X, +Y, -Y, +Z, -Z
+static const FVector FaceForward[6] = { FVector(1, 0, 0), FVector(-1, 0, 0), FVector(0, 1, 0), FVector(0, -1, 0), FVector(0, 0, 1), FVector(0, 0, -1) };
+static const FVector FaceRight[6] = { FVector(0, 1, 0), FVector(0, -1, 0), FVector(-1, 0, 0), FVector(1, 0, 0), FVector(0, 1, 0), FVector(0, 1, 0) };
+static const FVector FaceUp[6] = { FVector(0, 0, 1), FVector(0, 0, 1), FVector(0, 0, 1), FVector(0, 0, 1), FVector(-1, 0, 0), FVector(1, 0, 0) };
+
+// The level 0 backdrop sits slightly behind the finer tiles so they always cover it
+static const float BackdropScale = 1.05f;
+
+// Tiles are grown a little so neighbours overlap and no seams show between them
+static const float TileOverlap = 1.01f;
+
+static int32 getTileLevel(int32 key)
+{
+	return (key >> 20) & 15;
+}
+
+APanoramaViewer::APanoramaViewer()
+{
+	// Only ticks while a panorama is shown, a few times a second is enough to follow the view
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickInterval = 0.1f;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> PlaneFinder(TEXT("/Engine/BasicShapes/Plane.Plane"));
+	tileMesh = PlaneFinder.Object;
+	tileMaterial = NULL;
+	textureParameter = TEXT("Tile");
+	radius = 1000.0f;
+	maxResidentTiles = 96;
+	panorama = NULL;
+	generation = 0;
+	updateCount = 0;
+}
+
+void APanoramaViewer::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	updateTiles();
+}
+
+void APanoramaViewer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	hide();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APanoramaViewer::show(UPanoramaAsset *panoramaInput)
+{
+	if (panoramaInput == panorama)
+	{
+		return;
+	}
+
+	releaseTiles();
+	panorama = panoramaInput;
+	if (panorama == NULL)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	SetActorTickEnabled(true);
+	updateTiles();
+}
+
+void APanoramaViewer::hide()
+{
+	show(NULL);
+}
+
+void APanoramaViewer::updateTiles()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PanoramaUpdate);
+
+	APlayerController *playerController = GetWorld()->GetFirstPlayerController();
+	if (panorama == NULL || playerController == NULL || playerController->PlayerCameraManager == NULL)
+	{
+		return;
+	}
+
+	const FVector viewDirection = playerController->PlayerCameraManager->GetCameraRotation().Vector();
+	const float fov = playerController->PlayerCameraManager->GetFOVAngle();
+	FVector2D viewportSize(1280.0f, 720.0f);
+	if (GEngine->GameViewport != NULL)
+	{
+		GEngine->GameViewport->GetViewportSize(viewportSize);
+	}
+
+	// Half angle of the cone around the frustum's corners
+	const float aspect = viewportSize.Y / FMath::Max(viewportSize.X, 1.0f);
+	const float viewHalfAngle = FMath::Atan(FMath::Tan(FMath::DegreesToRadians(fov * 0.5f)) * FMath::Sqrt(1.0f + aspect * aspect));
+	const int32 level = selectLevel(fov, viewportSize.X);
+
+	updateCount++;
+	for (int32 face = 0; face < 6; face++)
+	{
+		requestTile(UPanoramaAsset::makeTileKey(face, 0, 0, 0), updateCount);
+
+		const int32 tilesPerSide = 1 << level;
+		for (int32 y = 0; level > 0 && y < tilesPerSide; y++)
+		{
+			for (int32 x = 0; x < tilesPerSide; x++)
+			{
+				if (isTileInView(face, level, x, y, viewDirection, viewHalfAngle))
+				{
+					requestTile(UPanoramaAsset::makeTileKey(face, level, x, y), updateCount);
+				}
+			}
+		}
+	}
+
+	// Show the resident tiles in view, and put the quads of the others back in the pool
+	for (int32 tileIndex = 0; tileIndex < residentTiles.Num(); tileIndex++)
+	{
+		FResidentTile &tile = residentTiles[tileIndex];
+		const bool wanted = tile.lastWanted == updateCount;
+		if (wanted && tile.quad == INDEX_NONE)
+		{
+			showTile(tileIndex);
+		}
+		else if (!wanted && tile.quad != INDEX_NONE)
+		{
+			quads[tile.quad]->SetVisibility(false);
+			freeQuads.Add(tile.quad);
+			tile.quad = INDEX_NONE;
+		}
+	}
+
+	evictTiles(updateCount);
+}
+
+int32 APanoramaViewer::selectLevel(float fovDegrees, float viewportWidth) const
+{
+	// A face spans 90 degrees, level n has tileSize * 2^n texels across it
+	const float screenPixelsPerDegree = viewportWidth / FMath::Max(fovDegrees, 1.0f);
+	const float levelZeroTexelsPerDegree = panorama->tileSize / 90.0f;
+	const int32 level = FMath::CeilToInt(FMath::Log2(FMath::Max(screenPixelsPerDegree / levelZeroTexelsPerDegree, 1.0f)));
+	return FMath::Clamp(level, 0, panorama->maxLevel);
+}
+
+bool APanoramaViewer::isTileInView(int32 face, int32 level, int32 x, int32 y, const FVector &viewDirection, float viewHalfAngle)
+{
+	// Tile center and half diagonal on the unit cube
+	const float tileSpan = 2.0f / (1 << level);
+	const float u = -1.0f + (x + 0.5f) * tileSpan;
+	const float v = -1.0f + (y + 0.5f) * tileSpan;
+	const FVector center = FaceForward[face] + FaceRight[face] * u + FaceUp[face] * v;
+	const float centerDistance = center.Size();
+	const float tileHalfAngle = FMath::Atan(tileSpan * 0.5f * UE_SQRT_2 / centerDistance);
+
+	const float angle = FMath::Acos(FMath::Clamp(FVector::DotProduct(viewDirection, center / centerDistance), -1.0f, 1.0f));
+	return angle <= viewHalfAngle + tileHalfAngle;
+}
+
+void APanoramaViewer::requestTile(int32 key, uint32 update)
+{
+	for (int32 tileIndex = 0; tileIndex < residentTiles.Num(); tileIndex++)
+	{
+		if (residentTiles[tileIndex].key == key)
+		{
+			residentTiles[tileIndex].lastWanted = update;
+			return;
+		}
+	}
+
+	if (loadingTiles.Contains(key))
+	{
+		return;
+	}
+
+	const int32 tileIndex = panorama->findTile(key);
+	UStartupLoader *loader = UStartupLoader::get(this);
+	if (tileIndex == INDEX_NONE || loader == NULL || panorama->tiles[tileIndex].texture.IsNull())
+	{
+		return;
+	}
+
+	const FStringAssetReference reference = panorama->tiles[tileIndex].texture.ToStringReference();
+	loadingTiles.Add(key);
+	loader->getStreamableManager().RequestAsyncLoad(reference, FStreamableDelegate::CreateUObject(this, &APanoramaViewer::onTileLoaded, reference, key, generation));
+}
+
+void APanoramaViewer::onTileLoaded(FStringAssetReference reference, int32 key, int32 loadGeneration)
+{
+	UStartupLoader *loader = UStartupLoader::get(this);
+	if (loadGeneration != generation)
+	{
+		// Loaded for a panorama that has since been replaced
+		if (loader != NULL)
+		{
+			loader->getStreamableManager().Unload(reference);
+		}
+		return;
+	}
+
+	loadingTiles.Remove(key);
+	const int32 tileIndex = panorama->findTile(key);
+	UTexture2D *texture = tileIndex != INDEX_NONE ? panorama->tiles[tileIndex].texture.Get() : NULL;
+	if (texture == NULL)
+	{
+		return;
+	}
+
+	// The next update shows the tile if it is still in view
+	FResidentTile tile;
+	tile.key = key;
+	tile.tileIndex = tileIndex;
+	tile.quad = INDEX_NONE;
+	tile.lastWanted = updateCount;
+	residentTiles.Add(tile);
+	residentTextures.Add(texture);
+	INC_DWORD_STAT(STAT_PanoramaResidentTiles);
+}
+
+void APanoramaViewer::showTile(int32 residentIndex)
+{
+	FResidentTile &tile = residentTiles[residentIndex];
+	if (freeQuads.Num() > 0)
+	{
+		tile.quad = freeQuads.Pop();
+	}
+	else
+	{
+		UStaticMeshComponent *quad = NewObject<UStaticMeshComponent>(this);
+		quad->SetStaticMesh(tileMesh);
+		quad->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		quad->CastShadow = false;
+		quad->AttachTo(RootComponent);
+		quad->RegisterComponent();
+
+		UMaterialInstanceDynamic *material = UMaterialInstanceDynamic::Create(tileMaterial, this);
+		quad->SetMaterial(0, material);
+
+		tile.quad = quads.Add(quad);
+		quadMaterials.Add(material);
+	}
+
+	const FPanoramaTile &panoramaTile = panorama->tiles[tile.tileIndex];
+	quadMaterials[tile.quad]->SetTextureParameterValue(textureParameter, residentTextures[residentIndex]);
+
+	// The quad faces the center from the tile's spot on the cube, the coarse backdrop a little further out
+	const int32 face = panoramaTile.face;
+	const float tileSpan = 2.0f / (1 << panoramaTile.level);
+	const float u = -1.0f + (panoramaTile.x + 0.5f) * tileSpan;
+	const float v = -1.0f + (panoramaTile.y + 0.5f) * tileSpan;
+	const float distance = panoramaTile.level == 0 ? radius * BackdropScale : radius;
+	const float quadScale = tileSpan * distance / 100.0f * TileOverlap;
+
+	UStaticMeshComponent *quad = quads[tile.quad];
+	quad->SetRelativeLocationAndRotation((FaceForward[face] + FaceRight[face] * u + FaceUp[face] * v) * distance,
+		FRotationMatrix::MakeFromZX(-FaceForward[face], FaceRight[face]).Rotator());
+	quad->SetRelativeScale3D(FVector(quadScale, quadScale, 1.0f));
+	quad->SetVisibility(true);
+}
+
+void APanoramaViewer::evictTiles(uint32 update)
+{
+	UStartupLoader *loader = UStartupLoader::get(this);
+	while (residentTiles.Num() > maxResidentTiles)
+	{
+		// The tile longest out of view goes first, the backdrop and the tiles in view are never released
+		int32 oldest = INDEX_NONE;
+		for (int32 tileIndex = 0; tileIndex < residentTiles.Num(); tileIndex++)
+		{
+			const FResidentTile &tile = residentTiles[tileIndex];
+			if (tile.lastWanted != update && getTileLevel(tile.key) > 0 && (oldest == INDEX_NONE || tile.lastWanted < residentTiles[oldest].lastWanted))
+			{
+				oldest = tileIndex;
+			}
+		}
+		if (oldest == INDEX_NONE)
+		{
+			return;
+		}
+
+		if (loader != NULL)
+		{
+			loader->getStreamableManager().Unload(panorama->tiles[residentTiles[oldest].tileIndex].texture.ToStringReference());
+		}
+		residentTiles.RemoveAtSwap(oldest);
+		residentTextures.RemoveAtSwap(oldest);
+		DEC_DWORD_STAT(STAT_PanoramaResidentTiles);
+	}
+}
+
+void APanoramaViewer::releaseTiles()
+{
+	UStartupLoader *loader = UStartupLoader::get(this);
+	for (int32 tileIndex = 0; tileIndex < residentTiles.Num(); tileIndex++)
+	{
+		if (loader != NULL)
+		{
+			loader->getStreamableManager().Unload(panorama->tiles[residentTiles[tileIndex].tileIndex].texture.ToStringReference());
+		}
+		DEC_DWORD_STAT(STAT_PanoramaResidentTiles);
+	}
+
+	for (int32 quadIndex = 0; quadIndex < quads.Num(); quadIndex++)
+	{
+		quads[quadIndex]->SetVisibility(false);
+	}
+
+	freeQuads.Reset();
+	for (int32 quadIndex = quads.Num() - 1; quadIndex >= 0; quadIndex--)
+	{
+		freeQuads.Add(quadIndex);
+	}
+
+	residentTiles.Reset();
+	residentTextures.Reset();
+	loadingTiles.Reset();
+	generation++;
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "PanoramaViewer.generated.h"
+
+class UPanoramaAsset;
+
+/**
+ * Shows a tiled cubemap panorama around the actor's location. The coarsest level of every face
+ * stays resident as a backdrop, and the tiles of the level matching the current zoom are streamed
+ * in only while they are inside the view frustum and drawn on quads in front of the backdrop.
+ * Tiles that leave the view are released once more than maxResidentTiles are loaded.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API APanoramaViewer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APanoramaViewer();
+
+	// Called every update interval while a panorama is shown
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Releases every tile
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Show a panorama, replacing the current one
+	void show(UPanoramaAsset *panoramaInput);
+
+	// Hide the panorama and release its tiles
+	void hide();
+
+	// Panorama being shown, NULL when hidden
+	UPanoramaAsset *getPanorama() const { return panorama; }
+
+	// Unlit material drawing a tile, its texture parameter is set to the tile's texture
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	class UMaterialInterface *tileMaterial;
+
+	// Texture parameter of the tile material
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	FName textureParameter;
+
+	// Unit quad the tiles are drawn on, 100 units across and facing up like the engine's plane
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	class UStaticMesh *tileMesh;
+
+	// Half the edge of the cube the tiles are drawn on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	float radius;
+
+	// Most tiles kept loaded, tiles out of view beyond this are released
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Panorama)
+	int32 maxResidentTiles;
+
+private:
+	struct FResidentTile
+	{
+		int32 key;
+		int32 tileIndex;
+		// Quad showing the tile, INDEX_NONE while hidden
+		int32 quad;
+		// Last update the tile was in view
+		uint32 lastWanted;
+	};
+
+	// Work out the tiles in view, stream in the missing ones and place the resident ones
+	void updateTiles();
+
+	// Level whose texel density matches the screen's at the given field of view
+	int32 selectLevel(float fovDegrees, float viewportWidth) const;
+
+	// Whether a tile can be seen within the cone around the view direction
+	static bool isTileInView(int32 face, int32 level, int32 x, int32 y, const FVector &viewDirection, float viewHalfAngle);
+
+	// Request a tile's texture if it is not loaded or loading
+	void requestTile(int32 key, uint32 update);
+
+	// Called when a tile's texture is resident, requests of a replaced panorama are ignored
+	void onTileLoaded(FStringAssetReference reference, int32 key, int32 loadGeneration);
+
+	// Place a quad showing the resident tile at the given index
+	void showTile(int32 residentIndex);
+
+	// Release every loaded and loading tile
+	void releaseTiles();
+
+	// Release the tiles longest out of view until at most maxResidentTiles remain
+	void evictTiles(uint32 update);
+
+	/** Panorama being shown */
+	UPROPERTY()
+	UPanoramaAsset *panorama;
+
+	TArray<FResidentTile> residentTiles;
+
+	/** Textures of residentTiles, in the same order */
+	UPROPERTY()
+	TArray<class UTexture2D *> residentTextures;
+
+	// Tiles requested and not yet loaded
+	TSet<int32> loadingTiles;
+
+	/** Quads the tiles are drawn on and their materials, reused as tiles come and go */
+	UPROPERTY()
+	TArray<class UStaticMeshComponent *> quads;
+	UPROPERTY()
+	TArray<class UMaterialInstanceDynamic *> quadMaterials;
+	TArray<int32> freeQuads;
+
+	// Bumped whenever the panorama changes so late loads of the old one are dropped
+	int32 generation;
+
+	// Updates run since play began
+	uint32 updateCount;
+};
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "PrecomputedVisibility.h"
+#include "EngineUtils.h"
+
+DECLARE_CYCLE_STAT(TEXT("Precomputed Visibility Apply"), STAT_PrecomputedVisibilityApply, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Precomputed Hidden Actors"), STAT_PrecomputedHiddenActors, STATGROUP_Kilograph);
+
+// Sets default values for this component's properties
+UPrecomputedVisibility::UPrecomputedVisibility()
+{
+	// Culling only changes when the character moves to another cell, it never needs to tick
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = false;
+
+	disableOcclusionQueries = false;
+	tableResolved = false;
+	currentCell = INDEX_NONE;
+	savedOcclusionQueries = INDEX_NONE;
+}
+
+FString UPrecomputedVisibility::getDefaultTablePath(const FString &mapName)
+{
+	return FPaths::GameContentDir() / TEXT("Visibility") / FPackageName::GetShortName(mapName) + TEXT(".kvis");
+}
+
+// Called when the game starts
+void UPrecomputedVisibility::BeginPlay()
+{
+	Super::BeginPlay();
+
+	resolveTable();
+}
+
+// Other actors may ask what the table covers before this component begins play, whichever comes first loads it
+void UPrecomputedVisibility::resolveTable()
+{
+	if (tableResolved)
+	{
+		return;
+	}
+	tableResolved = true;
+
+	UWorld *world = GetWorld();
+	const FString path = tablePath.IsEmpty() ? getDefaultTablePath(UWorld::RemovePIEPrefix(world->GetMapName())) : FPaths::GameContentDir() / tablePath;
+	if (!table.load(path))
+	{
+		return;
+	}
+
+	// Actors are matched by name within the persistent level
+	TMap<FString, AActor *> actorsByName;
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		if (actorIt->GetLevel() == world->PersistentLevel)
+		{
+			actorsByName.Add(actorIt->GetName(), *actorIt);
+		}
+	}
+
+	const TArray<FString> &actorNames = table.getActorNames();
+	actors.SetNum(actorNames.Num());
+	heldActors.Init(false, actorNames.Num());
+	int32 missingActors = 0;
+	for (int32 actorIndex = 0; actorIndex < actorNames.Num(); actorIndex++)
+	{
+		AActor **actor = actorsByName.Find(actorNames[actorIndex]);
+		actors[actorIndex] = actor != NULL ? *actor : NULL;
+		missingActors += actor != NULL ? 0 : 1;
+	}
+
+	if (missingActors > 0)
+	{
+		UE_LOG(Kilograph, Warning, TEXT("%d actors of visibility table %s are missing, the table may need rebaking"), missingActors, *path);
+	}
+}
+
+// Called when the component is removed from play
+void UPrecomputedVisibility::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	disable();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UPrecomputedVisibility::updateTour(const FString &tourName, float distance)
+{
+	if (hasTable())
+	{
+		applyCell(table.findTourCell(tourName, distance));
+	}
+}
+
+void UPrecomputedVisibility::updateOrbit(float xRotation, float zRotation)
+{
+	if (hasTable())
+	{
+		applyCell(table.findOrbitCell(xRotation, zRotation));
+	}
+}
+
+void UPrecomputedVisibility::disable()
+{
+	applyCell(INDEX_NONE);
+}
+
+bool UPrecomputedVisibility::coversActor(const AActor *actor)
+{
+	resolveTable();
+	for (int32 actorIndex = 0; actorIndex < actors.Num(); actorIndex++)
+	{
+		if (actors[actorIndex].Get() == actor)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UPrecomputedVisibility::findOrbitHiddenActors(bool includeExterior, TArray<int32> &outActorIndices) const
+{
+	outActorIndices.Reset();
+
+	int32 firstCell, numCells;
+	table.getOrbitCells(firstCell, numCells);
+	for (int32 actorIndex = 0; actorIndex < actors.Num(); actorIndex++)
+	{
+		bool visible = false;
+		for (int32 cell = firstCell; !includeExterior && !visible && cell < firstCell + numCells; cell++)
+		{
+			visible = table.isVisible(cell, actorIndex);
+		}
+
+		// Without an orbit in the table nothing is known to be hidden from it
+		if (includeExterior || (numCells > 0 && !visible))
+		{
+			outActorIndices.Add(actorIndex);
+		}
+	}
+}
+
+void UPrecomputedVisibility::holdActors(const TArray<int32> &actorIndices, bool hold)
+{
+	for (int32 index = 0; index < actorIndices.Num(); index++)
+	{
+		const int32 actorIndex = actorIndices[index];
+		heldActors[actorIndex] = hold;
+
+		// A released actor takes the visibility of the cell applied now
+		AActor *actor = actors[actorIndex].Get();
+		if (!hold && actor != NULL && currentCell != INDEX_NONE)
+		{
+			actor->SetActorHiddenInGame(!table.isVisible(currentCell, actorIndex));
+		}
+	}
+}
+
+void UPrecomputedVisibility::applyCell(int32 cell)
+{
+	if (cell == currentCell)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PrecomputedVisibilityApply);
+
+	// Only touch the actors whose visibility differs between the two cells, no cell means everything is shown
+	for (int32 actorIndex = 0; actorIndex < actors.Num(); actorIndex++)
+	{
+		const bool wasVisible = currentCell == INDEX_NONE || table.isVisible(currentCell, actorIndex);
+		const bool isVisible = cell == INDEX_NONE || table.isVisible(cell, actorIndex);
+		if (wasVisible == isVisible)
+		{
+			continue;
+		}
+
+		AActor *actor = actors[actorIndex].Get();
+		if (actor != NULL && !heldActors[actorIndex])
+		{
+			actor->SetActorHiddenInGame(!isVisible);
+		}
+
+		if (isVisible)
+		{
+			DEC_DWORD_STAT(STAT_PrecomputedHiddenActors);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_PrecomputedHiddenActors);
+		}
+	}
+
+	// The table replaces the renderer's occlusion culling while it is in charge
+	IConsoleVariable *occlusionQueries = IConsoleManager::Get().FindConsoleVariable(TEXT("r.AllowOcclusionQueries"));
+	if (occlusionQueries != NULL && disableOcclusionQueries)
+	{
+		if (currentCell == INDEX_NONE && cell != INDEX_NONE)
+		{
+			savedOcclusionQueries = occlusionQueries->GetInt();
+			occlusionQueries->Set(TEXT("0"));
+		}
+		else if (currentCell != INDEX_NONE && cell == INDEX_NONE && savedOcclusionQueries != INDEX_NONE)
+		{
+			occlusionQueries->Set(*FString::FromInt(savedOcclusionQueries));
+			savedOcclusionQueries = INDEX_NONE;
+		}
+	}
+
+	currentCell = cell;
+}
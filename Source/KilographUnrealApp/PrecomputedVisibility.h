@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "VisibilityTable.h"
+#include "PrecomputedVisibility.generated.h"
+
+/**
+ * Culls the scene from a baked visibility table while the camera is on one of its fixed paths,
+ * the tour or the orbit shell. Actors not visible from the camera's current cell are hidden.
+ * The table only covers the static meshes of the persistent level, so the renderer's occlusion
+ * queries stay on unless disableOcclusionQueries says the table covers everything that is loaded.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UPrecomputedVisibility : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UPrecomputedVisibility();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Cull for the camera at a distance along a tour
+	void updateTour(const FString &tourName, float distance);
+
+	// Cull for the camera at the given orbit rotations
+	void updateOrbit(float xRotation, float zRotation);
+
+	// Show everything the table hid and hand culling back to the renderer
+	void disable();
+
+	// Actors of the table not visible from any cell of the orbit shell, or every actor of the table if includeExterior is set
+	void findOrbitHiddenActors(bool includeExterior, TArray<int32> &outActorIndices) const;
+
+	// Whether the table shows and hides the actor, loads the table if play hasn't begun yet
+	bool coversActor(const AActor *actor);
+
+	// Actor of the table, NULL if it is missing from the map
+	AActor *getActor(int32 actorIndex) const { return actors[actorIndex].Get(); }
+
+	// Hand actors over to another system, which shows and hides them until they are released to the current cell
+	void holdActors(const TArray<int32> &actorIndices, bool hold);
+
+	// Whether a table was loaded for the current map
+	bool hasTable() const { return table.getNumCells() > 0; }
+
+	// Default location of the visibility table baked for a map
+	static FString getDefaultTablePath(const FString &mapName);
+
+	// Table to load, relative to the content directory, empty picks the default table of the map
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Visibility)
+	FString tablePath;
+
+	// Turn off the renderer's occlusion queries while the table culls, only for maps whose table covers every primitive,
+	// dynamic actors and streamed zones are otherwise left without occlusion culling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Visibility)
+	bool disableOcclusionQueries;
+
+private:
+	// Load the map's table and match its actors by name, once
+	void resolveTable();
+
+	// Show and hide the actors that differ between the current cell and the new one
+	void applyCell(int32 cell);
+
+	FVisibilityTable table;
+	bool tableResolved;
+
+	// Actors of the table, resolved by name when play begins
+	TArray<TWeakObjectPtr<AActor> > actors;
+
+	// Actors handed over to another system, the table leaves them alone
+	TArray<bool> heldActors;
+
+	// Cell currently applied, INDEX_NONE when the table is not culling
+	int32 currentCell;
+
+	// Occlusion query setting to restore once the table stops culling
+	int32 savedOcclusionQueries;
+};
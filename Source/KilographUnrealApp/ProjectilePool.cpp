@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "ProjectilePool.h"
+#include "KilographUnrealAppProjectile.h"
+#include "KilographUnrealAppGameMode.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Hits"), STAT_ProjectilePoolHits, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Free Pooled Projectiles"), STAT_FreePooledProjectiles, STATGROUP_Kilograph);
+
+UProjectilePool::UProjectilePool()
+{
+	hits = 0;
+	misses = 0;
+}
+
+UProjectilePool *UProjectilePool::get(const UObject *worldContextObject)
+{
+	UWorld *world = worldContextObject != NULL ? worldContextObject->GetWorld() : NULL;
+	if (world == NULL)
+	{
+		return NULL;
+	}
+
+	AKilographUnrealAppGameMode *gameMode = Cast<AKilographUnrealAppGameMode>(world->GetAuthGameMode());
+	return gameMode != NULL ? gameMode->getProjectilePool() : NULL;
+}
+
+UWorld *UProjectilePool::GetWorld() const
+{
+	// The class default object has no world
+	return HasAnyFlags(RF_ClassDefaultObject) ? NULL : GetOuter()->GetWorld();
+}
+
+void UProjectilePool::prewarm(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, int32 count)
+{
+	int32 freeOfClass = 0;
+	for (int32 projectileIndex = 0; projectileIndex < freeProjectiles.Num(); projectileIndex++)
+	{
+		if (freeProjectiles[projectileIndex] != NULL && freeProjectiles[projectileIndex]->GetClass() == *projectileClass)
+		{
+			freeOfClass++;
+		}
+	}
+
+	for (; freeOfClass < count; freeOfClass++)
+	{
+		AKilographUnrealAppProjectile *projectile = spawnProjectile(projectileClass, FVector::ZeroVector, FRotator::ZeroRotator);
+		if (projectile == NULL)
+		{
+			return;
+		}
+		release(projectile);
+	}
+}
+
+AKilographUnrealAppProjectile *UProjectilePool::acquire(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, const FVector &location, const FRotator &rotation)
+{
+	// Most recently released first, it is the most likely to still be in cache
+	for (int32 projectileIndex = freeProjectiles.Num() - 1; projectileIndex >= 0; projectileIndex--)
+	{
+		AKilographUnrealAppProjectile *projectile = freeProjectiles[projectileIndex];
+		if (projectile == NULL || projectile->IsPendingKill())
+		{
+			freeProjectiles.RemoveAtSwap(projectileIndex);
+			DEC_DWORD_STAT(STAT_FreePooledProjectiles);
+			continue;
+		}
+
+		if (projectile->GetClass() == *projectileClass)
+		{
+			freeProjectiles.RemoveAtSwap(projectileIndex);
+			DEC_DWORD_STAT(STAT_FreePooledProjectiles);
+			INC_DWORD_STAT(STAT_ProjectilePoolHits);
+			hits++;
+
+			projectile->launch(location, rotation);
+			return projectile;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_ProjectilePoolMisses);
+	misses++;
+
+	AKilographUnrealAppProjectile *projectile = spawnProjectile(projectileClass, location, rotation);
+	if (projectile != NULL)
+	{
+		projectile->launch(location, rotation);
+	}
+	return projectile;
+}
+
+void UProjectilePool::release(AKilographUnrealAppProjectile *projectile)
+{
+	if (projectile == NULL || freeProjectiles.Contains(projectile))
+	{
+		return;
+	}
+
+	projectile->retire();
+	freeProjectiles.Add(projectile);
+	INC_DWORD_STAT(STAT_FreePooledProjectiles);
+}
+
+void UProjectilePool::logStats() const
+{
+	const uint32 shots = hits + misses;
+	UE_LOG(Kilograph, Log, TEXT("Projectile pool: %u shots, %u hits, %u misses (%.1f%% hit rate), %d free"),
+		shots, hits, misses, shots > 0 ? 100.0f * hits / shots : 0.0f, freeProjectiles.Num());
+}
+
+AKilographUnrealAppProjectile *UProjectilePool::spawnProjectile(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, const FVector &location, const FRotator &rotation)
+{
+	UWorld *world = GetWorld();
+	if (world == NULL || *projectileClass == NULL)
+	{
+		return NULL;
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.bNoCollisionFail = true;
+
+	AKilographUnrealAppProjectile *projectile = world->SpawnActor<AKilographUnrealAppProjectile>(projectileClass, location, rotation, spawnParameters);
+	if (projectile != NULL)
+	{
+		projectile->setPool(this);
+	}
+	return projectile;
+}
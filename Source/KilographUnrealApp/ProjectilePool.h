@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "ProjectilePool.generated.h"
+
+class AKilographUnrealAppProjectile;
+
+/**
+ * World level pool of projectiles. Projectiles are spawned up front and recycled when they hit
+ * something or time out, instead of being spawned and destroyed for every shot.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UProjectilePool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UProjectilePool();
+
+	// Find the pool of the world the given object lives in
+	static UProjectilePool *get(const UObject *worldContextObject);
+
+	// The world of the game mode owning the pool
+	virtual UWorld *GetWorld() const override;
+
+	// Spawn projectiles ahead of time until count of the given class are waiting in the pool
+	void prewarm(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, int32 count);
+
+	// Launch a projectile from the pool, spawning a new one if none of that class is free
+	AKilographUnrealAppProjectile *acquire(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, const FVector &location, const FRotator &rotation);
+
+	// Put a projectile back into the pool
+	void release(AKilographUnrealAppProjectile *projectile);
+
+	// Shots served by a pooled projectile
+	uint32 getHits() const { return hits; }
+
+	// Shots that needed a new projectile to be spawned
+	uint32 getMisses() const { return misses; }
+
+	// Log the pool's hit and miss counts
+	void logStats() const;
+
+private:
+	// Spawn a projectile owned by the pool
+	AKilographUnrealAppProjectile *spawnProjectile(TSubclassOf<AKilographUnrealAppProjectile> projectileClass, const FVector &location, const FRotator &rotation);
+
+	/** Projectiles waiting to be fired */
+	UPROPERTY()
+	TArray<AKilographUnrealAppProjectile *> freeProjectiles;
+
+	uint32 hits;
+	uint32 misses;
+};
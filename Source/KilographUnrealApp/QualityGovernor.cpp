@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "QualityGovernor.h"
+#include "RHI.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Quality Level"), STAT_QualityLevel, STATGROUP_Kilograph);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governed Frame Ms"), STAT_GovernedFrameMs, STATGROUP_Kilograph);
+
+static TAutoConsoleVariable<int32> CVarQualityGovernor(
+	TEXT("kilo.QualityGovernor"),
+	1,
+	TEXT("Whether render settings are scaled to hold each state's frame time target.\n")
+	TEXT(" 0: off, the settings found at the start of play are used\n")
+	TEXT(" 1: on"));
+
+// Frames this many times over the target are hitches, they are left out of the smoothed time
+static const float HitchFactor = 4.0f;
+
+// Render settings in the order they are stored in settings
+enum EGovernedSetting
+{
+	ScreenPercentage,
+	ViewDistanceScale,
+	ShadowQuality,
+	LodDistanceScale
+};
+
+static FQualityProfile makeProfile(const TCHAR *state, float minScreenPercentage, float minViewDistanceScale, int32 minShadowQuality)
+{
+	FQualityProfile profile;
+	profile.state = state;
+	profile.minScreenPercentage = minScreenPercentage;
+	profile.minViewDistanceScale = minViewDistanceScale;
+	profile.minShadowQuality = minShadowQuality;
+	return profile;
+}
+
+// Sets default values for this component's properties
+UQualityGovernor::UQualityGovernor()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// The orbit has headroom, the tour and panorama give up resolution first, the panorama has nothing casting shadows
+	profiles.Add(makeProfile(TEXT("ORBIT"), 80.0f, 0.8f, 2));
+	profiles.Add(makeProfile(TEXT("FREERUN"), 70.0f, 0.6f, 1));
+	profiles.Add(makeProfile(TEXT("TOUR"), 65.0f, 0.5f, 1));
+	profiles.Add(makeProfile(TEXT("PANORAMA"), 60.0f, 1.0f, 0));
+
+	downshiftMargin = 0.05f;
+	upshiftMargin = 0.2f;
+	downshiftDelay = 0.5f;
+	upshiftDelay = 3.0f;
+	smoothingTime = 0.25f;
+
+	activeProfile = INDEX_NONE;
+	settings[ScreenPercentage].name = TEXT("r.ScreenPercentage");
+	settings[ViewDistanceScale].name = TEXT("r.ViewDistanceScale");
+	settings[ShadowQuality].name = TEXT("r.ShadowQuality");
+	settings[LodDistanceScale].name = TEXT("r.StaticMeshLODDistanceScale");
+	governing = false;
+	smoothedFrameMs = 0.0f;
+	overBudgetTime = 0.0f;
+	underBudgetTime = 0.0f;
+}
+
+void UQualityGovernor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	for (int32 settingIndex = 0; settingIndex < ARRAY_COUNT(settings); settingIndex++)
+	{
+		IConsoleVariable *variable = IConsoleManager::Get().FindConsoleVariable(settings[settingIndex].name);
+		settings[settingIndex].savedValue = variable != NULL ? variable->GetString() : FString();
+	}
+	governing = true;
+	if (activeProfile != INDEX_NONE)
+	{
+		applyLevel(getLevel());
+	}
+
+	for (int32 profileIndex = 0; profileIndex < profiles.Num(); profileIndex++)
+	{
+		const FQualityProfile &profile = profiles[profileIndex];
+		UE_LOG(Kilograph, Log, TEXT("Quality profile %s: %.1f ms target, %d levels, screen %.0f-%.0f%%, view distance %.2f-%.2f, shadows %d-%d, LOD distance %.2f-1"),
+			*profile.state, profile.targetFrameMs, profile.numLevels, profile.minScreenPercentage, profile.maxScreenPercentage,
+			profile.minViewDistanceScale, profile.maxViewDistanceScale, profile.minShadowQuality, profile.maxShadowQuality, profile.lowestLodDistanceScale);
+	}
+}
+
+void UQualityGovernor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	restoreSettings();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UQualityGovernor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (CVarQualityGovernor.GetValueOnGameThread() == 0)
+	{
+		restoreSettings();
+		return;
+	}
+
+	if (activeProfile == INDEX_NONE || DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	// Settings turned back on pick up where the state left off
+	if (!governing)
+	{
+		governing = true;
+		applyLevel(getLevel());
+	}
+
+	const FQualityProfile &profile = profiles[activeProfile];
+	const float frameMs = measureFrameMs(DeltaTime);
+	if (frameMs > profile.targetFrameMs * HitchFactor)
+	{
+		return;
+	}
+
+	smoothedFrameMs += (frameMs - smoothedFrameMs) * FMath::Min(DeltaTime / FMath::Max(smoothingTime, KINDA_SMALL_NUMBER), 1.0f);
+	SET_FLOAT_STAT(STAT_GovernedFrameMs, smoothedFrameMs);
+
+	// Only a sustained miss or a sustained margin changes the level
+	overBudgetTime = smoothedFrameMs > profile.targetFrameMs * (1.0f + downshiftMargin) ? overBudgetTime + DeltaTime : 0.0f;
+	underBudgetTime = smoothedFrameMs < profile.targetFrameMs * (1.0f - upshiftMargin) ? underBudgetTime + DeltaTime : 0.0f;
+
+	const int32 level = getLevel();
+	int32 newLevel = level;
+	if (overBudgetTime >= downshiftDelay)
+	{
+		newLevel = FMath::Max(level - 1, 0);
+	}
+	else if (underBudgetTime >= upshiftDelay)
+	{
+		newLevel = FMath::Min(level + 1, profile.numLevels - 1);
+	}
+
+	if (newLevel != level)
+	{
+		UE_LOG(Kilograph, Log, TEXT("Quality %s level %d -> %d at %.1f ms against %.1f ms"), *profile.state, level, newLevel, smoothedFrameMs, profile.targetFrameMs);
+		levels.Add(profile.state, newLevel);
+		applyLevel(newLevel);
+		overBudgetTime = 0.0f;
+		underBudgetTime = 0.0f;
+	}
+}
+
+void UQualityGovernor::setState(const FString &stateName)
+{
+	activeProfile = profiles.IndexOfByPredicate([&stateName](const FQualityProfile &profile) { return profile.state == stateName; });
+	overBudgetTime = 0.0f;
+	underBudgetTime = 0.0f;
+	if (activeProfile == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Start from the target so the frame time of the previous state doesn't count against this one
+	smoothedFrameMs = profiles[activeProfile].targetFrameMs;
+	if (governing)
+	{
+		applyLevel(getLevel());
+	}
+}
+
+int32 UQualityGovernor::getLevel() const
+{
+	if (activeProfile == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	// A state starts at its highest level
+	const FQualityProfile &profile = profiles[activeProfile];
+	const int32 *level = levels.Find(profile.state);
+	return level != NULL ? FMath::Clamp(*level, 0, profile.numLevels - 1) : FMath::Max(profile.numLevels - 1, 0);
+}
+
+float UQualityGovernor::measureFrameMs(float DeltaTime)
+{
+	// The GPU time is 0 where the RHI can't time frames, the frame's own time stands in for it
+	const float gameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	const float renderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	const uint32 gpuCycles = RHIGetGPUFrameCycles();
+	const float gpuMs = gpuCycles != 0 ? FPlatformTime::ToMilliseconds(gpuCycles) : DeltaTime * 1000.0f;
+	return FMath::Max3(gameThreadMs, renderThreadMs, gpuMs);
+}
+
+void UQualityGovernor::applyLevel(int32 level)
+{
+	const FQualityProfile &profile = profiles[activeProfile];
+	const float alpha = profile.numLevels > 1 ? (float)level / (profile.numLevels - 1) : 1.0f;
+	SET_DWORD_STAT(STAT_QualityLevel, level);
+
+	FString values[ARRAY_COUNT(settings)];
+	values[ScreenPercentage] = FString::SanitizeFloat(FMath::Lerp(profile.minScreenPercentage, profile.maxScreenPercentage, alpha));
+	values[ViewDistanceScale] = FString::SanitizeFloat(FMath::Lerp(profile.minViewDistanceScale, profile.maxViewDistanceScale, alpha));
+	values[ShadowQuality] = FString::FromInt(FMath::RoundToInt(FMath::Lerp((float)profile.minShadowQuality, (float)profile.maxShadowQuality, alpha)));
+	values[LodDistanceScale] = FString::SanitizeFloat(FMath::Lerp(profile.lowestLodDistanceScale, 1.0f, alpha));
+
+	for (int32 settingIndex = 0; settingIndex < ARRAY_COUNT(settings); settingIndex++)
+	{
+		IConsoleVariable *variable = IConsoleManager::Get().FindConsoleVariable(settings[settingIndex].name);
+		if (variable != NULL && variable->GetString() != values[settingIndex])
+		{
+			variable->Set(*values[settingIndex]);
+		}
+	}
+}
+
+void UQualityGovernor::restoreSettings()
+{
+	if (!governing)
+	{
+		return;
+	}
+
+	for (int32 settingIndex = 0; settingIndex < ARRAY_COUNT(settings); settingIndex++)
+	{
+		IConsoleVariable *variable = IConsoleManager::Get().FindConsoleVariable(settings[settingIndex].name);
+		if (variable != NULL && !settings[settingIndex].savedValue.IsEmpty())
+		{
+			variable->Set(*settings[settingIndex].savedValue);
+		}
+	}
+	governing = false;
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "QualityGovernor.generated.h"
+
+// Frame time target and the range of settings the governor may use in one state
+USTRUCT(BlueprintType)
+struct FQualityProfile
+{
+	GENERATED_USTRUCT_BODY()
+
+	// State the profile applies to, as named in the mode stats
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	FString state;
+
+	// Frame time to hold in milliseconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float targetFrameMs;
+
+	// Quality levels between the lowest and highest settings below
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	int32 numLevels;
+
+	// r.ScreenPercentage at the lowest and highest level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float minScreenPercentage;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float maxScreenPercentage;
+
+	// r.ViewDistanceScale at the lowest and highest level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float minViewDistanceScale;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float maxViewDistanceScale;
+
+	// r.ShadowQuality at the lowest and highest level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	int32 minShadowQuality;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	int32 maxShadowQuality;
+
+	// r.StaticMeshLODDistanceScale at the lowest level, the highest level uses 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float lowestLodDistanceScale;
+
+	FQualityProfile()
+		: targetFrameMs(16.6f)
+		, numLevels(5)
+		, minScreenPercentage(70.0f)
+		, maxScreenPercentage(100.0f)
+		, minViewDistanceScale(0.6f)
+		, maxViewDistanceScale(1.0f)
+		, minShadowQuality(1)
+		, maxShadowQuality(3)
+		, lowestLodDistanceScale(2.0f)
+	{
+	}
+};
+
+/**
+ * Holds the frame time of each app state by stepping render settings up and down. The frame is
+ * bound by the slowest of the game thread, render thread and GPU, and a level only drops after
+ * the frame has stayed over the state's target for a while and only rises after a longer stretch
+ * well under it, so the settings don't oscillate. Every state keeps its own level and profile,
+ * read from the Game config, and the settings in use before play are restored when play ends.
+ * Switched off with kilo.QualityGovernor 0.
+ */
+UCLASS( config=Game, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UQualityGovernor : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UQualityGovernor();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Restores the settings found at the start of play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Switch to the profile of a state and apply the level it last settled on
+	void setState(const FString &stateName);
+
+	// Current level of the active state, 0 is the lowest quality
+	int32 getLevel() const;
+
+	// Profiles of the states, states without one are left alone
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	TArray<FQualityProfile> profiles;
+
+	// Fraction over the target the frame must stay at before the level drops
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float downshiftMargin;
+
+	// Fraction under the target the frame must stay at before the level rises
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float upshiftMargin;
+
+	// Seconds over budget before the level drops
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float downshiftDelay;
+
+	// Seconds under budget before the level rises
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float upshiftDelay;
+
+	// Time constant in seconds of the smoothing applied to the frame time
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = Quality)
+	float smoothingTime;
+
+private:
+	// Render setting driven by the governor and its value before play
+	struct FGovernedSetting
+	{
+		const TCHAR *name;
+		FString savedValue;
+	};
+
+	// Slowest of the game thread, render thread and GPU over the last frame in ms
+	static float measureFrameMs(float DeltaTime);
+
+	// Set the render settings for a level of the active profile
+	void applyLevel(int32 level);
+
+	// Put back the settings found at the start of play
+	void restoreSettings();
+
+	// Index into profiles of the active state, INDEX_NONE if it has none
+	int32 activeProfile;
+
+	// Level each state settled on, by state name
+	TMap<FString, int32> levels;
+
+	FGovernedSetting settings[4];
+
+	// Whether the governor currently owns the settings, false while switched off
+	bool governing;
+
+	// Smoothed frame time and how long it has been over or under budget
+	float smoothedFrameMs;
+	float overBudgetTime;
+	float underBudgetTime;
+};
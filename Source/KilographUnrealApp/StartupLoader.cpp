@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "StartupLoader.h"
+#include "KilographUnrealAppGameMode.h"
+
+UStartupLoader::UStartupLoader()
+{
+	currentStage = INDEX_NONE;
+	firstInteractiveSeconds = -1.0;
+}
+
+UStartupLoader *UStartupLoader::get(const UObject *worldContextObject)
+{
+	UWorld *world = worldContextObject != NULL ? worldContextObject->GetWorld() : NULL;
+	if (world == NULL)
+	{
+		return NULL;
+	}
+
+	AKilographUnrealAppGameMode *gameMode = Cast<AKilographUnrealAppGameMode>(world->GetAuthGameMode());
+	return gameMode != NULL ? gameMode->getStartupLoader() : NULL;
+}
+
+void UStartupLoader::addStage(FName stageName, const TArray<FStringAssetReference> &assets)
+{
+	FStage stage;
+	stage.name = stageName;
+	stage.assets = assets;
+	stage.loaded = false;
+	stages.Add(stage);
+}
+
+void UStartupLoader::start()
+{
+	if (currentStage == INDEX_NONE)
+	{
+		requestNextStage();
+	}
+}
+
+bool UStartupLoader::isStageLoaded(FName stageName) const
+{
+	for (int32 stageIndex = 0; stageIndex < stages.Num(); stageIndex++)
+	{
+		if (stages[stageIndex].name == stageName)
+		{
+			return stages[stageIndex].loaded;
+		}
+	}
+	return false;
+}
+
+void UStartupLoader::requestNextStage()
+{
+	currentStage++;
+	if (!stages.IsValidIndex(currentStage))
+	{
+		if (firstInteractiveSeconds < 0.0)
+		{
+			firstInteractiveSeconds = FPlatformTime::Seconds() - GStartTime;
+			UE_LOG(Kilograph, Log, TEXT("First interactive after %.3f s"), firstInteractiveSeconds);
+		}
+		UE_LOG(Kilograph, Log, TEXT("Startup content loaded after %.3f s"), FPlatformTime::Seconds() - GStartTime);
+		return;
+	}
+
+	if (stages[currentStage].assets.Num() == 0)
+	{
+		onStageStreamed();
+		return;
+	}
+
+	// Only one stage streams at a time so earlier stages get the full bandwidth
+	streamableManager.RequestAsyncLoad(stages[currentStage].assets, FStreamableDelegate::CreateUObject(this, &UStartupLoader::onStageStreamed));
+}
+
+void UStartupLoader::onStageStreamed()
+{
+	FStage &stage = stages[currentStage];
+	stage.loaded = true;
+
+	for (int32 assetIndex = 0; assetIndex < stage.assets.Num(); assetIndex++)
+	{
+		UObject *asset = stage.assets[assetIndex].ResolveObject();
+		if (asset != NULL)
+		{
+			loadedAssets.Add(asset);
+		}
+		else
+		{
+			UE_LOG(Kilograph, Warning, TEXT("Startup stage %s could not load %s"), *stage.name.ToString(), *stage.assets[assetIndex].ToString());
+		}
+	}
+
+	if (firstInteractiveSeconds < 0.0)
+	{
+		firstInteractiveSeconds = FPlatformTime::Seconds() - GStartTime;
+		UE_LOG(Kilograph, Log, TEXT("First interactive after %.3f s"), firstInteractiveSeconds);
+	}
+	UE_LOG(Kilograph, Log, TEXT("Startup stage %s loaded after %.3f s"), *stage.name.ToString(), FPlatformTime::Seconds() - GStartTime);
+
+	onStageLoaded.Broadcast(stage.name);
+	requestNextStage();
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/StreamableManager.h"
+#include "StartupLoader.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FStartupStageLoadedSignature, FName);
+
+/**
+ * Streams the app's soft referenced content in asynchronously after the map has loaded, one
+ * stage at a time in priority order, so the first stage (the orbit view) becomes interactive
+ * without waiting on the content of the other modes.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UStartupLoader : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UStartupLoader();
+
+	// Find the loader of the world the given object lives in
+	static UStartupLoader *get(const UObject *worldContextObject);
+
+	// Queue a stage of assets, stages load in the order they are added
+	void addStage(FName stageName, const TArray<FStringAssetReference> &assets);
+
+	// Start streaming the queued stages
+	void start();
+
+	// Whether every asset of a stage is resident
+	bool isStageLoaded(FName stageName) const;
+
+	// Seconds from process start until the first stage was resident, negative until then
+	double getFirstInteractiveSeconds() const { return firstInteractiveSeconds; }
+
+	// Manager used for all asynchronous loads in the app
+	FStreamableManager &getStreamableManager() { return streamableManager; }
+
+	// Broadcast as each stage finishes loading
+	FStartupStageLoadedSignature onStageLoaded;
+
+private:
+	struct FStage
+	{
+		FName name;
+		TArray<FStringAssetReference> assets;
+		bool loaded;
+	};
+
+	// Request the next stage that still has to load
+	void requestNextStage();
+
+	// Called when the stage currently streaming is resident
+	void onStageStreamed();
+
+	FStreamableManager streamableManager;
+
+	TArray<FStage> stages;
+
+	// Index of the stage streaming now
+	int32 currentStage;
+
+	double firstInteractiveSeconds;
+
+	/** Keeps streamed assets from being garbage collected */
+	UPROPERTY()
+	TArray<UObject *> loadedAssets;
+};
@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "TouchGestures.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Touch Samples Dropped"), STAT_TouchSamplesDropped, STATGROUP_Kilograph);
+
+FTouchGestureRecognizer::FTouchGestureRecognizer()
+{
+	tapSlop = 10.0f;
+	maxTapTime = 0.3f;
+	reset();
+}
+
+void FTouchGestureRecognizer::reset()
+{
+	firstSample = 0;
+	numSamples = 0;
+	droppedSamples = 0;
+	numFingersDown = 0;
+	time = 0.0f;
+	FMemory::Memzero(fingers, sizeof(fingers));
+}
+
+void FTouchGestureRecognizer::beginTouch(int32 finger, const FVector &location)
+{
+	addSample(Begin, finger, location);
+}
+
+void FTouchGestureRecognizer::moveTouch(int32 finger, const FVector &location)
+{
+	addSample(Move, finger, location);
+}
+
+void FTouchGestureRecognizer::endTouch(int32 finger, const FVector &location)
+{
+	addSample(End, finger, location);
+}
+
+void FTouchGestureRecognizer::addSample(ESampleType type, int32 finger, const FVector &location)
+{
+	if (finger < 0 || finger >= MaxFingers)
+	{
+		return;
+	}
+
+	if (numSamples == MaxSamples)
+	{
+		// Only the latest position of a move matters, fold it into the finger's last queued move
+		for (int32 offset = numSamples - 1; type == Move && offset >= 0; offset--)
+		{
+			FSample &queued = samples[(firstSample + offset) % MaxSamples];
+			if (queued.finger == finger)
+			{
+				if (queued.type != Move)
+				{
+					break;
+				}
+				queued.location = FVector2D(location.X, location.Y);
+				return;
+			}
+		}
+
+		// Presses and releases are always queued, a lost release would leave its finger down for good
+		if (!makeRoom(type != Move))
+		{
+			droppedSamples++;
+			INC_DWORD_STAT(STAT_TouchSamplesDropped);
+			return;
+		}
+	}
+
+	FSample &sample = samples[(firstSample + numSamples) % MaxSamples];
+	sample.type = (uint8)type;
+	sample.finger = (uint8)finger;
+	sample.location = FVector2D(location.X, location.Y);
+	numSamples++;
+}
+
+bool FTouchGestureRecognizer::makeRoom(bool allowPresses)
+{
+	// A move followed by another move of the same finger folds into it, the drag covers the same ground
+	int32 removed = INDEX_NONE;
+	for (int32 offset = 0; offset < numSamples && removed == INDEX_NONE; offset++)
+	{
+		const FSample &queued = samples[(firstSample + offset) % MaxSamples];
+		for (int32 laterOffset = offset + 1; queued.type == Move && laterOffset < numSamples; laterOffset++)
+		{
+			const FSample &later = samples[(firstSample + laterOffset) % MaxSamples];
+			if (later.finger == queued.finger)
+			{
+				removed = later.type == Move ? offset : INDEX_NONE;
+				break;
+			}
+		}
+	}
+
+	// Then any move, only part of a drag is lost
+	for (int32 offset = 0; offset < numSamples && removed == INDEX_NONE; offset++)
+	{
+		removed = samples[(firstSample + offset) % MaxSamples].type == Move ? offset : INDEX_NONE;
+	}
+
+	// With only presses and releases queued, one that a later press or release of the same finger overrides
+	// goes, where each finger ends up is unchanged. There are more samples than fingers, so one always can.
+	for (int32 offset = 0; allowPresses && offset < numSamples && removed == INDEX_NONE; offset++)
+	{
+		const FSample &queued = samples[(firstSample + offset) % MaxSamples];
+		for (int32 laterOffset = offset + 1; laterOffset < numSamples; laterOffset++)
+		{
+			if (samples[(firstSample + laterOffset) % MaxSamples].finger == queued.finger)
+			{
+				removed = offset;
+				break;
+			}
+		}
+	}
+
+	if (removed == INDEX_NONE)
+	{
+		return false;
+	}
+
+	for (int32 offset = removed; offset < numSamples - 1; offset++)
+	{
+		samples[(firstSample + offset) % MaxSamples] = samples[(firstSample + offset + 1) % MaxSamples];
+	}
+	numSamples--;
+	droppedSamples++;
+	INC_DWORD_STAT(STAT_TouchSamplesDropped);
+	return true;
+}
+
+void FTouchGestureRecognizer::update(float DeltaSeconds, const FVector2D &viewportSize, FTouchGestures &outGestures)
+{
+	time += DeltaSeconds;
+
+	outGestures.taps.Reset();
+	outGestures.drag = FVector2D::ZeroVector;
+	outGestures.pinchScale = 1.0f;
+	outGestures.rotation = 0.0f;
+
+	for (; numSamples > 0; numSamples--)
+	{
+		applySample(samples[firstSample], viewportSize, outGestures);
+		firstSample = (firstSample + 1) % MaxSamples;
+	}
+}
+
+void FTouchGestureRecognizer::applySample(const FSample &sample, const FVector2D &viewportSize, FTouchGestures &outGestures)
+{
+	FFinger &finger = fingers[sample.finger];
+
+	switch (sample.type)
+	{
+	case Begin:
+	{
+		if (!finger.down)
+		{
+			numFingersDown++;
+		}
+		finger.down = true;
+		finger.moved = false;
+		finger.pressTime = time;
+		finger.start = sample.location;
+		finger.location = sample.location;
+
+		// A second finger turns the touch into a pinch, none of the fingers can tap anymore
+		if (numFingersDown > 1)
+		{
+			for (int32 fingerIndex = 0; fingerIndex < MaxFingers; fingerIndex++)
+			{
+				fingers[fingerIndex].moved = true;
+			}
+		}
+		break;
+	}
+	case Move:
+	{
+		if (!finger.down)
+		{
+			break;
+		}
+
+		int32 first, second;
+		if (findFingerPair(first, second) && (sample.finger == first || sample.finger == second))
+		{
+			// Compare the pair before and after the move
+			const FVector2D before = fingers[second].location - fingers[first].location;
+			finger.location = sample.location;
+			const FVector2D after = fingers[second].location - fingers[first].location;
+
+			const float beforeLength = before.Size();
+			if (beforeLength > KINDA_SMALL_NUMBER)
+			{
+				outGestures.pinchScale *= after.Size() / beforeLength;
+			}
+			const float angle = FMath::RadiansToDegrees(FMath::Atan2(after.Y, after.X) - FMath::Atan2(before.Y, before.X));
+			outGestures.rotation += FRotator::NormalizeAxis(angle);
+		}
+		else if (numFingersDown == 1)
+		{
+			if (viewportSize.X > 0.0f && viewportSize.Y > 0.0f)
+			{
+				outGestures.drag += (sample.location - finger.location) / viewportSize;
+			}
+			finger.location = sample.location;
+		}
+		else
+		{
+			finger.location = sample.location;
+		}
+
+		if (FVector2D::DistSquared(finger.start, finger.location) > tapSlop * tapSlop)
+		{
+			finger.moved = true;
+		}
+		break;
+	}
+	case End:
+	{
+		if (!finger.down)
+		{
+			break;
+		}
+
+		if (!finger.moved && time - finger.pressTime <= maxTapTime)
+		{
+			outGestures.taps.Add(FVector(sample.location.X, sample.location.Y, 0.0f));
+		}
+		finger.down = false;
+		numFingersDown--;
+		break;
+	}
+	}
+}
+
+bool FTouchGestureRecognizer::findFingerPair(int32 &outFirst, int32 &outSecond) const
+{
+	outFirst = INDEX_NONE;
+	outSecond = INDEX_NONE;
+	for (int32 fingerIndex = 0; fingerIndex < MaxFingers; fingerIndex++)
+	{
+		if (!fingers[fingerIndex].down)
+		{
+			continue;
+		}
+
+		if (outFirst == INDEX_NONE)
+		{
+			outFirst = fingerIndex;
+		}
+		else
+		{
+			outSecond = fingerIndex;
+			return true;
+		}
+	}
+	return false;
+}
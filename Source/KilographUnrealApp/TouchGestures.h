@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Gestures recognized over one frame
+struct FTouchGestures
+{
+	// Screen locations of the taps that ended this frame
+	TArray<FVector, TInlineAllocator<4> > taps;
+
+	// One finger drag as a fraction of the viewport size
+	FVector2D drag;
+
+	// Change in the distance between two fingers, above 1 when they spread apart
+	float pinchScale;
+
+	// Change in the angle between two fingers in degrees, clockwise on screen
+	float rotation;
+
+	FTouchGestures() : drag(FVector2D::ZeroVector), pinchScale(1.0f), rotation(0.0f) {}
+
+	bool isEmpty() const { return taps.Num() == 0 && drag.IsZero() && pinchScale == 1.0f && rotation == 0.0f; }
+};
+
+/**
+ * Turns raw touch events into gestures. Events are only queued in a preallocated ring buffer as
+ * they arrive, and once per frame the queue is replayed in order over the state of up to ten
+ * fingers to classify taps, one finger drags, and two finger pinches and rotations. Nothing is
+ * allocated per event. A full queue folds a move into the finger's last queued move, or makes
+ * room by coalescing queued moves, rather than growing; presses and releases are never dropped.
+ *
+ * Taps are only the releases that stayed within tapSlop and maxTapTime of their press. Before the
+ * recognizer every release traced for hotspots, so a drag or a long press ending on a hotspot no
+ * longer presses it.
+ */
+class KILOGRAPHUNREALAPP_API FTouchGestureRecognizer
+{
+public:
+	static const int32 MaxFingers = 10;
+	static const int32 MaxSamples = 128;
+
+	FTouchGestureRecognizer();
+
+	// Queue a touch event, called from the input callbacks
+	void beginTouch(int32 finger, const FVector &location);
+	void moveTouch(int32 finger, const FVector &location);
+	void endTouch(int32 finger, const FVector &location);
+
+	// Replay the queued events and classify them, viewportSize scales the drag
+	void update(float DeltaSeconds, const FVector2D &viewportSize, FTouchGestures &outGestures);
+
+	// Forget every finger and queued event
+	void reset();
+
+	// Distance in pixels a finger can travel and still tap
+	float tapSlop;
+
+	// Longest press in seconds that still counts as a tap
+	float maxTapTime;
+
+	// Events dropped or coalesced because the queue was full since the last reset
+	int32 getDroppedSamples() const { return droppedSamples; }
+
+private:
+	enum ESampleType
+	{
+		Begin,
+		Move,
+		End
+	};
+
+	struct FSample
+	{
+		uint8 type;
+		uint8 finger;
+		FVector2D location;
+	};
+
+	struct FFinger
+	{
+		bool down;
+		// Whether the finger has travelled beyond the tap slop or shared the screen with another finger
+		bool moved;
+		float pressTime;
+		FVector2D start;
+		FVector2D location;
+	};
+
+	void addSample(ESampleType type, int32 finger, const FVector &location);
+
+	// Free a queue slot by coalescing a queued move, or an overridden press or release if allowed; returns false if none can go
+	bool makeRoom(bool allowPresses);
+
+	// Apply one event to the fingers, accumulating the gestures it makes
+	void applySample(const FSample &sample, const FVector2D &viewportSize, FTouchGestures &outGestures);
+
+	// First two fingers down, returns false if fewer are down
+	bool findFingerPair(int32 &outFirst, int32 &outSecond) const;
+
+	FSample samples[MaxSamples];
+	int32 firstSample;
+	int32 numSamples;
+	int32 droppedSamples;
+
+	FFinger fingers[MaxFingers];
+	int32 numFingersDown;
+
+	// Time of the latest update, presses are timed at frame granularity
+	float time;
+};
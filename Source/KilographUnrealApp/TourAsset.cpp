@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "TourAsset.h"
+#include "TourPath.h"
+#include "Serialization/CustomVersion.h"
+
+// Versions of the tour asset layout, add one before VersionPlusOne whenever FTourControlPoint changes
+struct FTourAssetVersion
+{
+	enum Type
+	{
+		// Assets wrote their own version number ahead of the points
+		BeforeCustomVersionWasAdded = 0,
+		CustomVersionAdded,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+};
+
+const FGuid FTourAssetVersion::GUID(0x3A8C51E2, 0x4F0B47D6, 0x9B1E7C24, 0xD06A93F5);
+static FCustomVersionRegistration GRegisterTourAssetVersion(FTourAssetVersion::GUID, FTourAssetVersion::LatestVersion, TEXT("TourAsset"));
+
+UTourAsset::UTourAsset()
+{
+	samplesPerSegment = 16;
+}
+
+void UTourAsset::Serialize(FArchive &Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(FTourAssetVersion::GUID);
+	if (Ar.IsLoading() && Ar.CustomVer(FTourAssetVersion::GUID) < FTourAssetVersion::CustomVersionAdded)
+	{
+		int32 legacyVersion = 0;
+		Ar << legacyVersion;
+	}
+
+	// Points laid out differently from this build are skipped whole, so the rest of the package still loads
+	if (Ar.IsLoading())
+	{
+		const int64 pointsStart = Ar.Tell();
+		int32 elementSize = 0;
+		int32 numPoints = 0;
+		Ar << elementSize;
+		Ar << numPoints;
+		if (elementSize != sizeof(FTourControlPoint))
+		{
+			UE_LOG(Kilograph, Error, TEXT("Tour %s was saved with an unsupported layout and needs to be imported again"), *GetName());
+			Ar.Seek(Ar.Tell() + (int64)elementSize * numPoints);
+			controlPoints.Reset();
+			return;
+		}
+		Ar.Seek(pointsStart);
+	}
+
+	controlPoints.BulkSerialize(Ar);
+}
+
+void UTourAsset::buildPath(FTourPath &outPath) const
+{
+	TArray<FVector> locations;
+	locations.Reserve(controlPoints.Num());
+	for (int32 pointIndex = 0; pointIndex < controlPoints.Num(); pointIndex++)
+	{
+		locations.Add(controlPoints[pointIndex].location);
+	}
+	outPath.build(locations, samplesPerSegment);
+}
+
+void UTourAsset::setControlPoints(const TArray<FTourControlPoint> &controlPointsInput)
+{
+	controlPoints = controlPointsInput;
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "TourAsset.generated.h"
+
+struct FTourPath;
+
+// A point the tour passes through, laid out flat so a tour's points load as one block
+struct FTourControlPoint
+{
+	FTourControlPoint() : location(FVector::ZeroVector), speed(0.0f), dwell(0.0f), lookAt(FVector::ZeroVector), hasLookAt(0) {}
+
+	FVector location;
+
+	// Speed on the segment starting here in cm/sec, 0 uses the follower's tour speed
+	float speed;
+
+	// Seconds the tour rests on arriving here
+	float dwell;
+
+	// Point the view faces along the segment starting here, if hasLookAt is set
+	FVector lookAt;
+	uint32 hasLookAt;
+
+	friend FArchive &operator<<(FArchive &Ar, FTourControlPoint &point)
+	{
+		Ar << point.location;
+		Ar << point.speed;
+		Ar << point.dwell;
+		Ar << point.lookAt;
+		Ar << point.hasLookAt;
+		return Ar;
+	}
+};
+
+/**
+ * A camera tour baked out of the scene. The control points are stored as a single bulk
+ * serialized block, so loading a tour is one read and it needs no scene walk at runtime.
+ * Tours are created from the child actor setup of a camera follow by the TourImport commandlet.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UTourAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UTourAsset();
+
+	// Reads and writes the control points alongside the tagged properties
+	virtual void Serialize(FArchive &Ar) override;
+
+	// Bake the tour's spline
+	void buildPath(FTourPath &outPath) const;
+
+	// Points the tour passes through, in order
+	const TArray<FTourControlPoint> &getControlPoints() const { return controlPoints; }
+
+	// Replace the tour's points
+	void setControlPoints(const TArray<FTourControlPoint> &controlPointsInput);
+
+	// Name shown for the tour
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tour)
+	FText displayName;
+
+	// Spline samples baked between two control points
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tour)
+	int32 samplesPerSegment;
+
+private:
+	TArray<FTourControlPoint> controlPoints;
+};
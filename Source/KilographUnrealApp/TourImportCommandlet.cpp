@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "TourImportCommandlet.h"
+#include "VisibilityBakeCommandlet.h"
+#include "CameraFollow.h"
+#include "TourAsset.h"
+#include "EngineUtils.h"
+
+UTourImportCommandlet::UTourImportCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+void UTourImportCommandlet::parseTag(const AActor *element, const TCHAR *key, float &value)
+{
+	for (int32 tagIndex = 0; tagIndex < element->Tags.Num(); tagIndex++)
+	{
+		FParse::Value(*element->Tags[tagIndex].ToString(), key, value);
+	}
+}
+
+void UTourImportCommandlet::buildControlPoints(const TArray<AActor *> &pathElements, TArray<FTourControlPoint> &outControlPoints)
+{
+	outControlPoints.Reset();
+	for (int32 elementIndex = 0; elementIndex < pathElements.Num(); elementIndex++)
+	{
+		const AActor *element = pathElements[elementIndex];
+		FTourControlPoint point;
+		point.location = element->GetActorLocation();
+		parseTag(element, TEXT("TourSpeed="), point.speed);
+		parseTag(element, TEXT("TourDwell="), point.dwell);
+
+		FString lookAtName;
+		for (int32 tagIndex = 0; tagIndex < element->Tags.Num() && lookAtName.IsEmpty(); tagIndex++)
+		{
+			FParse::Value(*element->Tags[tagIndex].ToString(), TEXT("TourLookAt="), lookAtName);
+		}
+		if (!lookAtName.IsEmpty())
+		{
+			for (TActorIterator<AActor> actorIt(element->GetWorld()); actorIt; ++actorIt)
+			{
+				if (actorIt->GetName() == lookAtName)
+				{
+					point.lookAt = actorIt->GetActorLocation();
+					point.hasLookAt = 1;
+					break;
+				}
+			}
+			if (!point.hasLookAt)
+			{
+				UE_LOG(Kilograph, Warning, TEXT("%s looks at %s, which is not in the map"), *element->GetName(), *lookAtName);
+			}
+		}
+		outControlPoints.Add(point);
+	}
+}
+
+int32 UTourImportCommandlet::Main(const FString &Params)
+{
+#if WITH_EDITOR
+	FString mapName;
+	if (!FParse::Value(*Params, TEXT("Map="), mapName))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Usage: -run=TourImport -Map=<map> [-OutPath=/Game/Tours]"));
+		return 1;
+	}
+
+	FString outPath = TEXT("/Game/Tours");
+	FParse::Value(*Params, TEXT("OutPath="), outPath);
+
+	UWorld *world = UVisibilityBakeCommandlet::loadWorld(mapName);
+	if (world == NULL)
+	{
+		return 1;
+	}
+
+	int32 failures = 0;
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		UCameraFollow *follow = actorIt->FindComponentByClass<UCameraFollow>();
+		if (follow == NULL)
+		{
+			continue;
+		}
+
+		TArray<AActor *> pathElements;
+		follow->gatherPathElements(pathElements);
+		if (pathElements.Num() < 2)
+		{
+			UE_LOG(Kilograph, Warning, TEXT("Skipping %s, a tour needs at least two path elements"), *actorIt->GetName());
+			continue;
+		}
+
+		TArray<FTourControlPoint> controlPoints;
+		buildControlPoints(pathElements, controlPoints);
+
+		const FString assetName = FString::Printf(TEXT("%s_%s"), *FPackageName::GetShortName(mapName), *actorIt->GetName());
+		const FString packageName = outPath / assetName;
+		UPackage *package = CreatePackage(NULL, *packageName);
+		UTourAsset *tour = NewObject<UTourAsset>(package, *assetName, RF_Public | RF_Standalone);
+		tour->displayName = FText::FromString(actorIt->GetName());
+		tour->setControlPoints(controlPoints);
+		package->MarkPackageDirty();
+
+		const FString fileName = FPackageName::LongPackageNameToFilename(packageName, FPackageName::GetAssetPackageExtension());
+		if (UPackage::SavePackage(package, tour, RF_Public | RF_Standalone, *fileName))
+		{
+			UE_LOG(Kilograph, Display, TEXT("Imported %d control points of %s into %s"), controlPoints.Num(), *actorIt->GetName(), *packageName);
+		}
+		else
+		{
+			UE_LOG(Kilograph, Error, TEXT("Failed to save tour %s"), *fileName);
+			failures++;
+		}
+	}
+
+	UVisibilityBakeCommandlet::unloadWorld(world);
+	return failures > 0 ? 1 : 0;
+#else
+	UE_LOG(Kilograph, Error, TEXT("Tours can only be imported from an editor build"));
+	return 1;
+#endif
+}
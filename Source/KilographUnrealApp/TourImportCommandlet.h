@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "TourAsset.h"
+#include "TourImportCommandlet.generated.h"
+
+/**
+ * Bakes the child actor camera paths of a map into tour assets. Every camera follow in the map
+ * becomes one tour, with its path elements in attachment order as the control points. A path
+ * element's tags can set the speed of the segment it starts and the time the tour rests on it,
+ * as "TourSpeed=<cm/sec>" and "TourDwell=<seconds>", and an actor of the map the view faces along
+ * that segment, as "TourLookAt=<actor name>".
+ *
+ * Usage: UE4Editor-Cmd <Project> -run=TourImport -Map=/Game/Maps/Building [-OutPath=/Game/Tours]
+ *
+ * The assets are named <Map>_<Actor> and still have to be added to the camera follow's tours.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UTourImportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTourImportCommandlet();
+
+	// Import the tours of the map given on the command line
+	virtual int32 Main(const FString &Params) override;
+
+	// Control points of a path, read from the elements' locations and tags, look at targets are found in the elements' world
+	static void buildControlPoints(const TArray<AActor *> &pathElements, TArray<FTourControlPoint> &outControlPoints);
+
+private:
+	// Read a float from a path element's "<key>=<value>" tag, leaving the value alone if there is none
+	static void parseTag(const AActor *element, const TCHAR *key, float &value);
+};
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "TourPath.h"
+
+FTourPath::FTourPath()
+	: length(0.0f)
+{
+}
+
+void FTourPath::build(const TArray<FVector>& controlPoints, int32 samplesPerSegment)
+{
+	samplePositions.Reset();
+	sampleDirections.Reset();
+	sampleDistances.Reset();
+	controlPointDistances.Reset();
+	length = 0.0f;
+
+	const int32 numPoints = controlPoints.Num();
+	if (numPoints < 2)
+	{
+		return;
+	}
+
+	samplesPerSegment = FMath::Max(samplesPerSegment, 1);
+	samplePositions.Reserve(numPoints * samplesPerSegment + 1);
+
+	// Sample every segment of the loop, the last segment runs from the last point back to the first
+	for (int32 pointIndex = 0; pointIndex < numPoints; pointIndex++)
+	{
+		const FVector &p0 = controlPoints[(pointIndex + numPoints - 1) % numPoints];
+		const FVector &p1 = controlPoints[pointIndex];
+		const FVector &p2 = controlPoints[(pointIndex + 1) % numPoints];
+		const FVector &p3 = controlPoints[(pointIndex + 2) % numPoints];
+
+		for (int32 sampleIndex = 0; sampleIndex < samplesPerSegment; sampleIndex++)
+		{
+			samplePositions.Add(evaluateSegment(p0, p1, p2, p3, (float)sampleIndex / samplesPerSegment));
+		}
+	}
+	samplePositions.Add(controlPoints[0]);
+
+	// Accumulate the arc-length table
+	const int32 numSamples = samplePositions.Num();
+	sampleDistances.AddUninitialized(numSamples);
+	sampleDistances[0] = 0.0f;
+	for (int32 sampleIndex = 1; sampleIndex < numSamples; sampleIndex++)
+	{
+		sampleDistances[sampleIndex] = sampleDistances[sampleIndex - 1] + FVector::Dist(samplePositions[sampleIndex - 1], samplePositions[sampleIndex]);
+	}
+	length = sampleDistances[numSamples - 1];
+
+	// Every segment starts with its control point
+	controlPointDistances.AddUninitialized(numPoints);
+	for (int32 pointIndex = 0; pointIndex < numPoints; pointIndex++)
+	{
+		controlPointDistances[pointIndex] = sampleDistances[pointIndex * samplesPerSegment];
+	}
+
+	// Central difference tangents, wrapping around the loop (the last sample duplicates the first)
+	sampleDirections.AddUninitialized(numSamples);
+	for (int32 sampleIndex = 0; sampleIndex < numSamples - 1; sampleIndex++)
+	{
+		const FVector &previous = samplePositions[(sampleIndex + numSamples - 2) % (numSamples - 1)];
+		const FVector &next = samplePositions[sampleIndex + 1];
+		sampleDirections[sampleIndex] = (next - previous).GetSafeNormal();
+	}
+	sampleDirections[numSamples - 1] = sampleDirections[0];
+}
+
+int32 FTourPath::findSegment(float distance, float &alpha) const
+{
+	alpha = 0.0f;
+	if (!isValid())
+	{
+		return 0;
+	}
+
+	distance = wrapDistance(distance);
+	const int32 numPoints = controlPointDistances.Num();
+	int32 pointIndex = 0;
+	int32 high = numPoints - 1;
+	while (pointIndex < high)
+	{
+		const int32 middle = (pointIndex + high + 1) / 2;
+		if (controlPointDistances[middle] <= distance)
+		{
+			pointIndex = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	const float segmentEnd = pointIndex + 1 < numPoints ? controlPointDistances[pointIndex + 1] : length;
+	const float segmentLength = segmentEnd - controlPointDistances[pointIndex];
+	alpha = segmentLength > KINDA_SMALL_NUMBER ? (distance - controlPointDistances[pointIndex]) / segmentLength : 0.0f;
+	return pointIndex;
+}
+
+float FTourPath::wrapDistance(float distance) const
+{
+	if (length <= KINDA_SMALL_NUMBER)
+	{
+		return 0.0f;
+	}
+
+	distance = FMath::Fmod(distance, length);
+	if (distance < 0.0f)
+	{
+		distance += length;
+	}
+	return distance;
+}
+
+FVector FTourPath::getLocationAtDistance(float distance) const
+{
+	if (!isValid())
+	{
+		return samplePositions.Num() > 0 ? samplePositions[0] : FVector::ZeroVector;
+	}
+
+	float alpha;
+	const int32 sampleIndex = findSample(wrapDistance(distance), alpha);
+	return FMath::Lerp(samplePositions[sampleIndex], samplePositions[sampleIndex + 1], alpha);
+}
+
+FVector FTourPath::getDirectionAtDistance(float distance) const
+{
+	if (!isValid())
+	{
+		return FVector::ForwardVector;
+	}
+
+	float alpha;
+	const int32 sampleIndex = findSample(wrapDistance(distance), alpha);
+	const FVector direction = FMath::Lerp(sampleDirections[sampleIndex], sampleDirections[sampleIndex + 1], alpha).GetSafeNormal();
+	return direction.IsZero() ? sampleDirections[sampleIndex] : direction;
+}
+
+int32 FTourPath::findSample(float distance, float &alpha) const
+{
+	// Binary search for the last sample at or before the distance
+	int32 low = 0;
+	int32 high = sampleDistances.Num() - 2;
+	while (low < high)
+	{
+		const int32 middle = (low + high + 1) / 2;
+		if (sampleDistances[middle] <= distance)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	const float intervalLength = sampleDistances[low + 1] - sampleDistances[low];
+	alpha = intervalLength > KINDA_SMALL_NUMBER ? FMath::Clamp((distance - sampleDistances[low]) / intervalLength, 0.0f, 1.0f) : 0.0f;
+	return low;
+}
+
+FVector FTourPath::evaluateSegment(const FVector &p0, const FVector &p1, const FVector &p2, const FVector &p3, float t)
+{
+	// Centripetal knot spacing (alpha = 0.5), guarded against coincident control points
+	const float t0 = 0.0f;
+	const float t1 = t0 + FMath::Max(FMath::Sqrt(FVector::Dist(p0, p1)), KINDA_SMALL_NUMBER);
+	const float t2 = t1 + FMath::Max(FMath::Sqrt(FVector::Dist(p1, p2)), KINDA_SMALL_NUMBER);
+	const float t3 = t2 + FMath::Max(FMath::Sqrt(FVector::Dist(p2, p3)), KINDA_SMALL_NUMBER);
+	const float u = FMath::Lerp(t1, t2, t);
+
+	// Barry-Goldman pyramidal evaluation
+	const FVector a1 = p0 * ((t1 - u) / (t1 - t0)) + p1 * ((u - t0) / (t1 - t0));
+	const FVector a2 = p1 * ((t2 - u) / (t2 - t1)) + p2 * ((u - t1) / (t2 - t1));
+	const FVector a3 = p2 * ((t3 - u) / (t3 - t2)) + p3 * ((u - t2) / (t3 - t2));
+	const FVector b1 = a1 * ((t2 - u) / (t2 - t0)) + a2 * ((u - t0) / (t2 - t0));
+	const FVector b2 = a2 * ((t3 - u) / (t3 - t1)) + a3 * ((u - t1) / (t3 - t1));
+	return b1 * ((t2 - u) / (t2 - t1)) + b2 * ((u - t1) / (t2 - t1));
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Closed centripetal Catmull-Rom spline through a set of control points.
+ * The spline is baked once into an arc-length table so that it can be sampled by
+ * distance travelled, which gives constant speed playback independent of frame rate.
+ */
+struct KILOGRAPHUNREALAPP_API FTourPath
+{
+	FTourPath();
+
+	// Bake the spline through the given control points, looping back to the first one
+	void build(const TArray<FVector>& controlPoints, int32 samplesPerSegment = 16);
+
+	// Whether the path has been baked with enough points to be sampled
+	bool isValid() const { return sampleDistances.Num() > 1 && length > KINDA_SMALL_NUMBER; }
+
+	// Total length of the loop
+	float getLength() const { return length; }
+
+	// Wrap a distance into the [0, length) range of the loop
+	float wrapDistance(float distance) const;
+
+	// Location on the path at the given distance from the first control point
+	FVector getLocationAtDistance(float distance) const;
+
+	// Unit direction of travel at the given distance from the first control point
+	FVector getDirectionAtDistance(float distance) const;
+
+	// Number of control points the path was built through
+	int32 getNumControlPoints() const { return controlPointDistances.Num(); }
+
+	// Distance along the path of a control point
+	float getControlPointDistance(int32 pointIndex) const { return controlPointDistances[pointIndex]; }
+
+	// Control point starting the segment at the given distance, returns the blend towards the next control point
+	int32 findSegment(float distance, float &alpha) const;
+
+private:
+	// Find the sample interval containing the given wrapped distance, returns the blend within it
+	int32 findSample(float distance, float &alpha) const;
+
+	// Evaluate a centripetal Catmull-Rom segment between p1 and p2
+	static FVector evaluateSegment(const FVector &p0, const FVector &p1, const FVector &p2, const FVector &p3, float t);
+
+	/** Baked arc-length table */
+	TArray<FVector> samplePositions;
+	TArray<FVector> sampleDirections;
+	TArray<float> sampleDistances;
+
+	/** Distance of each control point along the loop */
+	TArray<float> controlPointDistances;
+
+	float length;
+};
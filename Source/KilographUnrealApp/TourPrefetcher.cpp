@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "TourPrefetcher.h"
+#include "CameraFollow.h"
+#include "ZoneStreamer.h"
+#include "ContentStreaming.h"
+#include "Engine/LevelStreaming.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tour Prefetch"), STAT_TourPrefetch, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Prefetched Levels"), STAT_PrefetchedLevels, STATGROUP_Kilograph);
+
+// Sets default values for this component's properties
+UTourPrefetcher::UTourPrefetcher()
+{
+	// Looking ahead a few times a second is plenty, and only while the tour runs
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickInterval = 0.25f;
+
+	lookaheadSeconds = 5.0f;
+	sampleSpacing = 500.0f;
+	textureBoost = 1.0f;
+	memoryBudgetMB = 0.0f;
+	tour = NULL;
+	zoneStreamer = NULL;
+}
+
+// Called when the game starts
+void UTourPrefetcher::BeginPlay()
+{
+	Super::BeginPlay();
+
+	levelBounds.SetNum(streamingLevels.Num());
+	requested.Init(false, streamingLevels.Num());
+	for (int32 levelIndex = 0; levelIndex < streamingLevels.Num(); levelIndex++)
+	{
+		AActor *boundsActor = streamingLevels[levelIndex].boundsActor;
+		levelBounds[levelIndex] = boundsActor != NULL ? boundsActor->GetComponentsBoundingBox(true) : FBox(0);
+	}
+}
+
+void UTourPrefetcher::startPrefetching(UCameraFollow *tourInput)
+{
+	tour = tourInput;
+	SetComponentTickEnabled(tour != NULL);
+}
+
+void UTourPrefetcher::stopPrefetching()
+{
+	tour = NULL;
+	SetComponentTickEnabled(false);
+}
+
+// Called at the prefetch interval while the tour runs
+void UTourPrefetcher::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TourPrefetch);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (tour == NULL || !tour->getTourPath().isValid())
+	{
+		return;
+	}
+
+	const FTourPath &path = tour->getTourPath();
+	const float distance = tour->getDistanceAlongPath();
+	const float spacing = FMath::Max(sampleSpacing, 1.0f);
+	// Keep texture requests alive until the next prefetch pass
+	const float requestDuration = PrimaryComponentTick.TickInterval * 2.0f;
+
+	TArray<bool> wanted;
+	wanted.Init(false, streamingLevels.Num());
+
+	// The window ahead is the travel time, each sample taking as long as its spacing at the speed the tour has there.
+	// Rests at control points are left out, so slow parts are prefetched a little early rather than late
+	float travelTime = 0.0f;
+	for (float ahead = 0.0f; ahead <= path.getLength() && travelTime <= lookaheadSeconds; ahead += spacing)
+	{
+		travelTime += spacing / FMath::Max(tour->getSpeedAtDistance(distance + ahead), 1.0f);
+		const FVector location = path.getLocationAtDistance(distance + ahead);
+		IStreamingManager::Get().AddViewSlaveLocation(location, textureBoost, false, requestDuration);
+
+		for (int32 levelIndex = 0; levelIndex < levelBounds.Num(); levelIndex++)
+		{
+			if (!wanted[levelIndex] && levelBounds[levelIndex].IsValid && levelBounds[levelIndex].IsInside(location))
+			{
+				wanted[levelIndex] = true;
+			}
+		}
+	}
+
+	for (int32 levelIndex = 0; levelIndex < streamingLevels.Num(); levelIndex++)
+	{
+		// Zones load and unload with the zone streamer's hysteresis and memory ceiling
+		if (!wanted[levelIndex] || requested[levelIndex] ||
+			(zoneStreamer != NULL && zoneStreamer->requestZone(streamingLevels[levelIndex].levelName)))
+		{
+			continue;
+		}
+
+		ULevelStreaming *level = UGameplayStatics::GetStreamingLevel(this, streamingLevels[levelIndex].levelName);
+		if (level != NULL)
+		{
+			// Load ahead of time without showing it, visibility is still up to the level's own streaming
+			level->bShouldBeLoaded = true;
+			requested[levelIndex] = true;
+			INC_DWORD_STAT(STAT_PrefetchedLevels);
+		}
+	}
+
+	if (memoryBudgetMB > 0.0f && FPlatformMemory::GetStats().UsedPhysical > (uint64)(memoryBudgetMB * 1024.0f * 1024.0f))
+	{
+		evictLevelBehind(wanted);
+	}
+}
+
+bool UTourPrefetcher::evictLevelBehind(const TArray<bool> &wanted)
+{
+	const FTourPath &path = tour->getTourPath();
+	const float distance = tour->getDistanceAlongPath();
+	const float spacing = FMath::Max(sampleSpacing, 1.0f);
+
+	// How far back along the path the player was last inside each level, the level left longest ago is reached again last.
+	// Levels the path never passes through count as a whole loop behind
+	TArray<float> behind;
+	behind.Init(path.getLength(), streamingLevels.Num());
+	TArray<bool> found;
+	found.Init(false, streamingLevels.Num());
+	for (float back = 0.0f; back < path.getLength(); back += spacing)
+	{
+		const FVector location = path.getLocationAtDistance(distance - back);
+		for (int32 levelIndex = 0; levelIndex < levelBounds.Num(); levelIndex++)
+		{
+			if (!found[levelIndex] && levelBounds[levelIndex].IsValid && levelBounds[levelIndex].IsInside(location))
+			{
+				found[levelIndex] = true;
+				behind[levelIndex] = back;
+			}
+		}
+	}
+
+	// Unload the level furthest behind that is neither around the player nor ahead on the path
+	int32 evictedLevel = INDEX_NONE;
+	for (int32 levelIndex = 0; levelIndex < streamingLevels.Num(); levelIndex++)
+	{
+		if (requested[levelIndex] && !wanted[levelIndex] && behind[levelIndex] > 0.0f &&
+			(evictedLevel == INDEX_NONE || behind[levelIndex] > behind[evictedLevel]))
+		{
+			evictedLevel = levelIndex;
+		}
+	}
+
+	if (evictedLevel == INDEX_NONE)
+	{
+		return false;
+	}
+
+	ULevelStreaming *level = UGameplayStatics::GetStreamingLevel(this, streamingLevels[evictedLevel].levelName);
+	if (level != NULL)
+	{
+		level->bShouldBeLoaded = false;
+		level->bShouldBeVisible = false;
+	}
+	requested[evictedLevel] = false;
+	DEC_DWORD_STAT(STAT_PrefetchedLevels);
+	return true;
+}
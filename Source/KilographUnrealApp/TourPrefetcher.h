@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "TourPrefetcher.generated.h"
+
+class UCameraFollow;
+class UZoneStreamer;
+
+/** A streaming level and the area of the scene it covers */
+USTRUCT()
+struct FTourStreamingLevel
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Name of the streaming level */
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	FName levelName;
+
+	/** Actor whose bounds cover the level's content, usually a volume */
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	AActor *boundsActor;
+
+	FTourStreamingLevel() : boundsActor(NULL) {}
+};
+
+/**
+ * Looks ahead along the camera tour of its owner and requests the streaming levels and texture
+ * mips the player is about to reach, evicting levels left behind when memory runs over budget.
+ * Ticks only while the tour is running.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UTourPrefetcher : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UTourPrefetcher();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called at the prefetch interval while the tour runs
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Start prefetching for the tour
+	void startPrefetching(UCameraFollow *tourInput);
+
+	// Stop prefetching, whatever was requested stays loaded
+	void stopPrefetching();
+
+	// Hand the levels that are zones of a zone streamer to it rather than loading them here, NULL takes them back
+	void setZoneStreamer(UZoneStreamer *zoneStreamerInput) { zoneStreamer = zoneStreamerInput; }
+
+	// How far ahead of the player content is requested, in seconds of travel at the tour's speeds along the way
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Prefetch)
+	float lookaheadSeconds;
+
+	// Spacing of the points sampled along the path ahead, in cm
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Prefetch)
+	float sampleSpacing;
+
+	// Boost applied to texture streaming around the points ahead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Prefetch)
+	float textureBoost;
+
+	// Used physical memory above which levels behind the player are unloaded, in MB, 0 never unloads
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Prefetch)
+	float memoryBudgetMB;
+
+	// Streaming levels along the tour
+	UPROPERTY(EditAnywhere, Category = Prefetch)
+	TArray<FTourStreamingLevel> streamingLevels;
+
+private:
+	// Unload the prefetched level the player left furthest back along the path, returns false if there is none
+	bool evictLevelBehind(const TArray<bool> &wanted);
+
+	// The tour being prefetched for
+	UCameraFollow *tour;
+
+	// Zone streamer loading the levels it knows as zones, NULL if there is none
+	UZoneStreamer *zoneStreamer;
+
+	// Bounds of each streaming level, resolved when play begins
+	TArray<FBox> levelBounds;
+
+	// Which streaming levels this component has asked to load
+	TArray<bool> requested;
+};
@@ -0,0 +1,284 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "VisibilityBakeCommandlet.h"
+#include "VisibilityTable.h"
+#include "PrecomputedVisibility.h"
+#include "CameraFollow.h"
+#include "KilographUnrealAppCharacter.h"
+#include "OrbitCamera.h"
+#include "EngineUtils.h"
+
+// Hits this close to an actor's bounds count as reaching the actor, whatever was hit
+static const float BoundsHitTolerance = 1.0f;
+
+UVisibilityBakeCommandlet::UVisibilityBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	boundsSamples = 4;
+}
+
+UWorld *UVisibilityBakeCommandlet::loadWorld(const FString &mapName)
+{
+	UPackage *package = LoadPackage(NULL, *mapName, LOAD_None);
+	UWorld *world = package != NULL ? UWorld::FindWorldInPackage(package) : NULL;
+	if (world == NULL)
+	{
+		UE_LOG(Kilograph, Error, TEXT("Could not load map %s"), *mapName);
+		return NULL;
+	}
+
+	world->AddToRoot();
+	world->WorldType = EWorldType::Editor;
+	if (!world->bIsWorldInitialized)
+	{
+		// Only collision is needed, traces run against the physics scene
+		UWorld::InitializationValues initializationValues;
+		initializationValues.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+		world->InitWorld(initializationValues);
+	}
+	world->UpdateWorldComponents(true, false);
+	return world;
+}
+
+void UVisibilityBakeCommandlet::unloadWorld(UWorld *world)
+{
+	world->CleanupWorld();
+	world->RemoveFromRoot();
+	CollectGarbage(RF_Native);
+}
+
+int32 UVisibilityBakeCommandlet::Main(const FString &Params)
+{
+	FString mapName;
+	if (!FParse::Value(*Params, TEXT("Map="), mapName))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Usage: -run=VisibilityBake -Map=<map> [-Out=<file>] [-TourCell=200] [-OrbitPitchCells=8] [-OrbitYawCells=36] [-BoundsSamples=4]"));
+		return 1;
+	}
+
+	FString outPath = UPrecomputedVisibility::getDefaultTablePath(mapName);
+	FParse::Value(*Params, TEXT("Out="), outPath);
+	float tourCellLength = 200.0f;
+	FParse::Value(*Params, TEXT("TourCell="), tourCellLength);
+	int32 orbitPitchCells = 8;
+	FParse::Value(*Params, TEXT("OrbitPitchCells="), orbitPitchCells);
+	int32 orbitYawCells = 36;
+	FParse::Value(*Params, TEXT("OrbitYawCells="), orbitYawCells);
+	boundsSamples = 4;
+	FParse::Value(*Params, TEXT("BoundsSamples="), boundsSamples);
+	boundsSamples = FMath::Clamp(boundsSamples, 1, 16);
+
+	UWorld *world = loadWorld(mapName);
+	if (world == NULL)
+	{
+		return 1;
+	}
+
+	// The orbit shell and the skybox come from the character placed in the map
+	AKilographUnrealAppCharacter *character = NULL;
+	TArray<UCameraFollow *> tours;
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		if (character == NULL)
+		{
+			character = Cast<AKilographUnrealAppCharacter>(*actorIt);
+		}
+
+		UCameraFollow *tour = actorIt->FindComponentByClass<UCameraFollow>();
+		if (tour != NULL)
+		{
+			tours.Add(tour);
+		}
+	}
+
+	TArray<AActor *> skyboxActors;
+	if (character != NULL)
+	{
+		ignoredActors.Add(character);
+		if (character->skyboxCenter != NULL)
+		{
+			TArray<USceneComponent *> skyboxComponents;
+			character->skyboxCenter->GetRootComponent()->GetChildrenComponents(true, skyboxComponents);
+			skyboxActors.Add(character->skyboxCenter);
+			for (int32 componentIndex = 0; componentIndex < skyboxComponents.Num(); componentIndex++)
+			{
+				skyboxActors.AddUnique(skyboxComponents[componentIndex]->GetOwner());
+			}
+		}
+	}
+
+	// Only static meshes that never move can be culled from a baked table, the skybox is left to its visibility group
+	TArray<FString> actorNames;
+	for (TActorIterator<AActor> actorIt(world); actorIt; ++actorIt)
+	{
+		AActor *actor = *actorIt;
+		if (actor->GetLevel() != world->PersistentLevel || actor->bHidden || skyboxActors.Contains(actor) ||
+			actor->GetRootComponent() == NULL || actor->GetRootComponent()->Mobility != EComponentMobility::Static ||
+			actor->FindComponentByClass<UStaticMeshComponent>() == NULL)
+		{
+			continue;
+		}
+
+		candidates.Add(actor);
+		actorNames.Add(actor->GetName());
+	}
+
+	FVisibilityTable table;
+	table.reset(actorNames);
+
+	const FVector eyeOffset = character != NULL ? character->GetFirstPersonCameraComponent()->RelativeLocation : FVector(0.0f, 0.0f, 64.0f);
+
+	for (int32 followIndex = 0; followIndex < tours.Num(); followIndex++)
+	{
+		UCameraFollow *tour = tours[followIndex];
+		tour->bakePath();
+
+		// Every tour asset of the follower gets its own cells, a follower without assets has its scene path
+		for (int32 tourIndex = 0; tourIndex < FMath::Max(tour->getNumTours(), 1); tourIndex++)
+		{
+			tour->selectTour(tourIndex);
+			const FTourPath &path = tour->getTourPath();
+			if (!path.isValid())
+			{
+				continue;
+			}
+
+			const FString tourName = tour->getTourName();
+			const int32 firstCell = table.addTour(tourName, path.getLength(), tourCellLength);
+			const int32 numCells = table.getNumCells() - firstCell;
+			UE_LOG(Kilograph, Display, TEXT("Baking %d cells along tour %s"), numCells, *tourName);
+
+			for (int32 cell = firstCell; cell < firstCell + numCells; cell++)
+			{
+				// The start, middle and end of the stretch of path in the cell
+				const float centerDistance = table.getTourCellDistance(tourName, cell);
+				TArray<FVector> viewpoints;
+				for (int32 sampleIndex = -1; sampleIndex <= 1; sampleIndex++)
+				{
+					const float distance = FMath::Clamp(centerDistance + sampleIndex * 0.5f * tourCellLength, 0.0f, path.getLength());
+					viewpoints.Add(path.getLocationAtDistance(distance) + eyeOffset);
+				}
+				bakeCell(world, table, cell, viewpoints);
+			}
+
+			// What pops into view between two cells' viewpoints is covered by either side
+			table.dilateCells(firstCell, 1, numCells);
+		}
+	}
+
+	if (character != NULL && character->rotationObject != NULL)
+	{
+		const int32 firstCell = table.addOrbit(character->minRotationX, character->maxRotationX, orbitPitchCells, orbitYawCells);
+		const int32 numCells = table.getNumCells() - firstCell;
+		const float pitchStep = (character->maxRotationX - character->minRotationX) / FMath::Max(orbitPitchCells, 1);
+		const float yawStep = 360.0f / FMath::Max(orbitYawCells, 1);
+		const FVector target = character->rotationObject->GetActorLocation();
+		UE_LOG(Kilograph, Display, TEXT("Baking %d cells on the orbit shell"), numCells);
+
+		// The views are placed by the character's own orbit camera, pulled in from the orbit distance wherever it would be in geometry
+		UOrbitCamera *orbitCamera = character->GetOrbitCamera();
+		orbitCamera->startOrbit(target, character->rotationDistance);
+		auto orbitViewpoint = [orbitCamera](float pitch, float yaw)
+		{
+			orbitCamera->setAngles(pitch, yaw);
+			return orbitCamera->getCameraLocation();
+		};
+
+		for (int32 cell = firstCell; cell < firstCell + numCells; cell++)
+		{
+			// The center and corners of the patch of shell in the cell
+			float pitch;
+			float yaw;
+			table.getOrbitCellAngles(cell, pitch, yaw);
+			TArray<FVector> viewpoints;
+			viewpoints.Add(orbitViewpoint(pitch, yaw));
+			for (int32 corner = 0; corner < 4; corner++)
+			{
+				const float cornerPitch = pitch + ((corner & 1) ? 0.5f : -0.5f) * pitchStep;
+				const float cornerYaw = yaw + ((corner & 2) ? 0.5f : -0.5f) * yawStep;
+				viewpoints.Add(orbitViewpoint(cornerPitch, cornerYaw));
+			}
+			bakeCell(world, table, cell, viewpoints);
+		}
+
+		orbitCamera->stopOrbit();
+		table.dilateCells(firstCell, orbitPitchCells, orbitYawCells);
+	}
+
+	const bool saved = table.save(outPath);
+	UE_LOG(Kilograph, Display, TEXT("Baked visibility of %d actors over %d cells to %s"), candidates.Num(), table.getNumCells(), *outPath);
+
+	unloadWorld(world);
+	return saved ? 0 : 1;
+}
+
+void UVisibilityBakeCommandlet::bakeCell(UWorld *world, FVisibilityTable &table, int32 cell, const TArray<FVector> &viewpoints)
+{
+	for (int32 actorIndex = 0; actorIndex < candidates.Num(); actorIndex++)
+	{
+		for (int32 viewpointIndex = 0; viewpointIndex < viewpoints.Num(); viewpointIndex++)
+		{
+			if (isActorVisibleFrom(world, viewpoints[viewpointIndex], candidates[actorIndex]))
+			{
+				table.setVisible(cell, actorIndex);
+				break;
+			}
+		}
+	}
+}
+
+bool UVisibilityBakeCommandlet::isActorVisibleFrom(UWorld *world, const FVector &viewpoint, AActor *actor) const
+{
+	const FBox bounds = actor->GetComponentsBoundingBox();
+	if (bounds.IsInside(viewpoint))
+	{
+		return true;
+	}
+
+	FCollisionQueryParams traceParams(FName(TEXT("VisibilityBake")), true);
+	traceParams.AddIgnoredActors(ignoredActors);
+	const FBox reachedBounds = bounds.ExpandBy(BoundsHitTolerance);
+
+	// A grid of points over each face of the bounds turned towards the viewpoint. A trace reaching the bounds
+	// counts even if it hit something else there, so an actor showing through a gap anywhere on its bounds is kept
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		const bool maxFace = viewpoint[axis] > bounds.Max[axis];
+		if (!maxFace && viewpoint[axis] >= bounds.Min[axis])
+		{
+			continue;
+		}
+
+		const int32 uAxis = (axis + 1) % 3;
+		const int32 vAxis = (axis + 2) % 3;
+		for (int32 u = 0; u < boundsSamples; u++)
+		{
+			for (int32 v = 0; v < boundsSamples; v++)
+			{
+				FVector samplePoint;
+				samplePoint[axis] = maxFace ? bounds.Max[axis] : bounds.Min[axis];
+				samplePoint[uAxis] = FMath::Lerp(bounds.Min[uAxis], bounds.Max[uAxis], (u + 0.5f) / boundsSamples);
+				samplePoint[vAxis] = FMath::Lerp(bounds.Min[vAxis], bounds.Max[vAxis], (v + 0.5f) / boundsSamples);
+
+				FHitResult hit(ForceInit);
+				if (!world->LineTraceSingleByChannel(hit, viewpoint, samplePoint, ECC_Visibility, traceParams) ||
+					hit.GetActor() == actor || reachedBounds.IsInside(hit.ImpactPoint))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
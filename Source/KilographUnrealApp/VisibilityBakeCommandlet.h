@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "VisibilityBakeCommandlet.generated.h"
+
+class FVisibilityTable;
+
+/**
+ * Bakes the visibility table of a map. The camera tours and the orbit shell of the map's placed
+ * character are split into cells, and every static mesh actor is traced against from a few
+ * viewpoints in each cell to find which cells can see it. The orbit viewpoints are where the
+ * character's orbit camera puts the view, pulled in from geometry. The test is conservative: a
+ * grid of -BoundsSamples points a side is traced on each face of an actor's bounds turned to the
+ * viewpoint, reaching the bounds anywhere counts as seen, and every cell is then dilated so it
+ * also keeps what its neighbours see.
+ *
+ * Usage: UE4Editor-Cmd <Project> -run=VisibilityBake -Map=/Game/Maps/Building
+ *		[-Out=<file>] [-TourCell=200] [-OrbitPitchCells=8] [-OrbitYawCells=36] [-BoundsSamples=4]
+ *
+ * The table is written next to the content, under Content/Visibility, which has to be staged as a
+ * non-asset directory when packaging.
+ */
+UCLASS()
+class KILOGRAPHUNREALAPP_API UVisibilityBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVisibilityBakeCommandlet();
+
+	// Bake the table of the map given on the command line
+	virtual int32 Main(const FString &Params) override;
+
+	// Load a map and get its world ready for traces, returns NULL if it could not be loaded
+	static UWorld *loadWorld(const FString &mapName);
+
+	// Tear down a world loaded with loadWorld
+	static void unloadWorld(UWorld *world);
+
+private:
+	// Mark every actor visible from any of the viewpoints as visible from the cell
+	void bakeCell(UWorld *world, FVisibilityTable &table, int32 cell, const TArray<FVector> &viewpoints);
+
+	// Whether any sample point of the actor's bounds can be seen from the viewpoint
+	bool isActorVisibleFrom(UWorld *world, const FVector &viewpoint, AActor *actor) const;
+
+	// Points traced along each side of a bounds face
+	int32 boundsSamples;
+
+	// Actors covered by the table
+	TArray<AActor *> candidates;
+
+	// Actors that never block the view, such as the character
+	TArray<AActor *> ignoredActors;
+};
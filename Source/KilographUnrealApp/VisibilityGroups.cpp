@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "VisibilityGroups.h"
+
+DECLARE_CYCLE_STAT(TEXT("Visibility Group Apply"), STAT_VisibilityGroupApply, STATGROUP_Kilograph);
+DECLARE_CYCLE_STAT(TEXT("Visibility Group Resolve"), STAT_VisibilityGroupResolve, STATGROUP_Kilograph);
+
+// Actors processed between checks of the frame's time budget
+static const int32 ActorsPerBudgetCheck = 8;
+
+// Sets default values for this component's properties
+UVisibilityGroups::UVisibilityGroups()
+{
+	// Only ticks while a visibility change is being spread over several frames
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	budgetMs = 0.0f;
+}
+
+// Called when the game starts
+void UVisibilityGroups::BeginPlay()
+{
+	Super::BeginPlay();
+
+	levelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UVisibilityGroups::onLevelsChanged);
+	levelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UVisibilityGroups::onLevelsChanged);
+	actorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UVisibilityGroups::onActorSpawned));
+}
+
+// Called when the component is removed from play
+void UVisibilityGroups::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(levelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(levelRemovedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(actorSpawnedHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame while visibility changes are pending
+void UVisibilityGroups::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const double deadline = FPlatformTime::Seconds() + budgetMs * 0.001;
+	while (pendingGroups.Num() > 0)
+	{
+		FVisibilityGroup *group = groups.Find(pendingGroups[0]);
+		if (group != NULL && !applyGroup(*group, deadline))
+		{
+			return;
+		}
+		pendingGroups.RemoveAt(0);
+	}
+
+	SetComponentTickEnabled(false);
+}
+
+void UVisibilityGroups::addGroup(FName groupName, AActor *root)
+{
+	FVisibilityGroup &group = groups.FindOrAdd(groupName);
+	group.root = root;
+	group.resolved = false;
+}
+
+void UVisibilityGroups::setGroupHidden(FName groupName, bool hide)
+{
+	FVisibilityGroup *group = groups.Find(groupName);
+	if (group == NULL)
+	{
+		UE_LOG(Kilograph, Warning, TEXT("Unknown visibility group %s"), *groupName.ToString());
+		return;
+	}
+
+	resolveGroup(*group);
+
+	// Nothing to do if the group is already fully in the requested state
+	if (group->hidden == hide && group->nextActor >= group->actors.Num())
+	{
+		return;
+	}
+
+	group->hidden = hide;
+	group->nextActor = 0;
+
+	const bool budgeted = budgetMs > 0.0f;
+	if (applyGroup(*group, budgeted ? FPlatformTime::Seconds() + budgetMs * 0.001 : 0.0))
+	{
+		pendingGroups.Remove(groupName);
+		return;
+	}
+
+	pendingGroups.AddUnique(groupName);
+	SetComponentTickEnabled(true);
+}
+
+bool UVisibilityGroups::isGroupHidden(FName groupName) const
+{
+	const FVisibilityGroup *group = groups.Find(groupName);
+	return group != NULL && group->hidden;
+}
+
+void UVisibilityGroups::invalidateGroup(FName groupName)
+{
+	FVisibilityGroup *group = groups.Find(groupName);
+	if (group != NULL)
+	{
+		group->resolved = false;
+	}
+}
+
+void UVisibilityGroups::invalidateGroups()
+{
+	for (auto groupIt = groups.CreateIterator(); groupIt; ++groupIt)
+	{
+		groupIt.Value().resolved = false;
+	}
+}
+
+void UVisibilityGroups::onLevelsChanged(ULevel *level, UWorld *world)
+{
+	if (world == GetWorld())
+	{
+		invalidateGroups();
+	}
+}
+
+void UVisibilityGroups::onActorSpawned(AActor *actor)
+{
+	invalidateGroups();
+}
+
+void UVisibilityGroups::warmGroup(FName groupName)
+{
+	FVisibilityGroup *group = groups.Find(groupName);
+	if (group != NULL)
+	{
+		resolveGroup(*group);
+	}
+}
+
+void UVisibilityGroups::resolveGroup(FVisibilityGroup &group)
+{
+	if (group.resolved)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_VisibilityGroupResolve);
+
+	AActor *root = group.root.Get();
+	USceneComponent *rootComponent = root != NULL ? root->GetRootComponent() : NULL;
+	if (rootComponent == NULL)
+	{
+		group.actors.Reset();
+		group.resolved = true;
+		return;
+	}
+
+	childComponents.Reset();
+	rootComponent->GetChildrenComponents(true, childComponents);
+
+	TSet<AActor *> seenActors;
+	group.actors.Reset();
+	for (int childIndex = 0; childIndex < childComponents.Num(); childIndex++)
+	{
+		AActor *childActor = childComponents[childIndex]->GetOwner();
+		if (!seenActors.Contains(childActor))
+		{
+			seenActors.Add(childActor);
+			group.actors.Add(childActor);
+		}
+	}
+
+	group.resolved = true;
+	// A fresh actor list has not had the group's visibility applied yet
+	group.nextActor = 0;
+}
+
+bool UVisibilityGroups::applyGroup(FVisibilityGroup &group, double deadline)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VisibilityGroupApply);
+
+	const int32 numActors = group.actors.Num();
+	while (group.nextActor < numActors)
+	{
+		AActor *actor = group.actors[group.nextActor].Get();
+		group.nextActor++;
+
+		if (actor == NULL)
+		{
+			// The actor is gone, pick up the new hierarchy next time the group is used
+			group.resolved = false;
+		}
+		else if (actor->bHidden != group.hidden)
+		{
+			actor->SetActorHiddenInGame(group.hidden);
+		}
+
+		if (deadline > 0.0 && group.nextActor % ActorsPerBudgetCheck == 0 && FPlatformTime::Seconds() >= deadline)
+		{
+			return group.nextActor >= numActors;
+		}
+	}
+
+	return true;
+}
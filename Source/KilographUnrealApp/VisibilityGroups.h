@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "VisibilityGroups.generated.h"
+
+/**
+ * Named sets of actors that are shown and hidden together, such as the skybox. Each group is
+ * made of the actors attached below a root actor; the list is resolved once and cached until it
+ * is invalidated, by a level streaming in or out, an actor being spawned, an actor of the group
+ * being destroyed, or invalidateGroup from code that re-attaches actors under a root. Visibility
+ * changes are applied in one pass over the cached actors, optionally spread over several frames
+ * within a time budget.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UVisibilityGroups : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UVisibilityGroups();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is removed from play
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame while visibility changes are pending
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Add a group made of the actors attached below the root actor
+	void addGroup(FName groupName, AActor *root);
+
+	// Show or hide every actor in a group
+	void setGroupHidden(FName groupName, bool hide);
+
+	// Whether the group was last requested hidden
+	bool isGroupHidden(FName groupName) const;
+
+	// Drop the cached actor list of a group, it is resolved again on next use; call after attaching or detaching actors below its root
+	void invalidateGroup(FName groupName);
+
+	// Drop the cached actor lists of every group
+	void invalidateGroups();
+
+	// Resolve a group's actor list ahead of time so the next visibility change doesn't walk the hierarchy
+	void warmGroup(FName groupName);
+
+	// Time in milliseconds a visibility change may spend per frame, 0 applies the whole group at once
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Visibility)
+	float budgetMs;
+
+private:
+	struct FVisibilityGroup
+	{
+		FVisibilityGroup() : resolved(false), hidden(false), nextActor(0) {}
+
+		TWeakObjectPtr<AActor> root;
+		TArray<TWeakObjectPtr<AActor> > actors;
+		bool resolved;
+		bool hidden;
+		// Index of the next actor to apply the visibility to, actors.Num() once the group is up to date
+		int32 nextActor;
+	};
+
+	// Gather the group's actors if the cache was invalidated
+	void resolveGroup(FVisibilityGroup &group);
+
+	// Invalidate every group when a level streams in or out
+	void onLevelsChanged(ULevel *level, UWorld *world);
+
+	// Invalidate every group when an actor is spawned, it may be attached below a root
+	void onActorSpawned(AActor *actor);
+
+	// Apply the group's visibility to its pending actors, returns true once all are done
+	bool applyGroup(FVisibilityGroup &group, double deadline);
+
+	TMap<FName, FVisibilityGroup> groups;
+
+	// Components below a group's root, kept between resolves to save the allocation
+	TArray<USceneComponent *> childComponents;
+
+	// Groups with visibility changes still to apply
+	TArray<FName> pendingGroups;
+
+	FDelegateHandle levelAddedHandle;
+	FDelegateHandle levelRemovedHandle;
+	FDelegateHandle actorSpawnedHandle;
+};
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "VisibilityTable.h"
+
+// Identifies visibility table files and their layout
+static const uint32 VisibilityTableMagic = 0x5349564B; // 'KVIS'
+static const uint32 VisibilityTableVersion = 1;
+
+FArchive &operator<<(FArchive &Ar, FVisibilityTable &table)
+{
+	Ar << table.actorNames;
+	Ar << table.tours;
+	Ar << table.orbitMinPitch;
+	Ar << table.orbitMaxPitch;
+	Ar << table.orbitPitchCells;
+	Ar << table.orbitYawCells;
+	Ar << table.orbitFirstCell;
+	Ar << table.wordsPerCell;
+	Ar << table.numCells;
+	table.bits.BulkSerialize(Ar);
+	return Ar;
+}
+
+FVisibilityTable::FVisibilityTable()
+{
+	reset(TArray<FString>());
+}
+
+void FVisibilityTable::reset(const TArray<FString> &actorNamesInput)
+{
+	actorNames = actorNamesInput;
+	tours.Reset();
+	orbitMinPitch = 0.0f;
+	orbitMaxPitch = 0.0f;
+	orbitPitchCells = 0;
+	orbitYawCells = 0;
+	orbitFirstCell = INDEX_NONE;
+	wordsPerCell = (actorNames.Num() + 31) / 32;
+	numCells = 0;
+	bits.Reset();
+}
+
+int32 FVisibilityTable::addCells(int32 count)
+{
+	const int32 firstCell = numCells;
+	numCells += count;
+	bits.AddZeroed(count * wordsPerCell);
+	return firstCell;
+}
+
+int32 FVisibilityTable::addTour(const FString &tourName, float pathLength, float cellLength)
+{
+	FTourCells tour;
+	tour.name = tourName;
+	tour.cellLength = FMath::Max(cellLength, 1.0f);
+	tour.numCells = FMath::Max(FMath::CeilToInt(pathLength / tour.cellLength), 1);
+	tour.firstCell = addCells(tour.numCells);
+	tours.Add(tour);
+	return tour.firstCell;
+}
+
+int32 FVisibilityTable::addOrbit(float minPitch, float maxPitch, int32 pitchCells, int32 yawCells)
+{
+	orbitMinPitch = minPitch;
+	orbitMaxPitch = FMath::Max(maxPitch, minPitch);
+	orbitPitchCells = FMath::Max(pitchCells, 1);
+	orbitYawCells = FMath::Max(yawCells, 1);
+	orbitFirstCell = addCells(orbitPitchCells * orbitYawCells);
+	return orbitFirstCell;
+}
+
+void FVisibilityTable::setVisible(int32 cell, int32 actorIndex)
+{
+	bits[cell * wordsPerCell + (actorIndex >> 5)] |= 1u << (actorIndex & 31);
+}
+
+void FVisibilityTable::dilateCells(int32 firstCell, int32 numRows, int32 rowLength)
+{
+	// Spread from a copy so only what the cells saw themselves spreads, by one cell
+	const TArray<uint32> original = bits;
+	for (int32 row = 0; row < numRows; row++)
+	{
+		for (int32 column = 0; column < rowLength; column++)
+		{
+			const int32 neighbours[4] = {
+				row * rowLength + (column + rowLength - 1) % rowLength, row * rowLength + (column + 1) % rowLength,
+				row > 0 ? (row - 1) * rowLength + column : INDEX_NONE, row + 1 < numRows ? (row + 1) * rowLength + column : INDEX_NONE };
+			uint32 *cellBits = &bits[(firstCell + row * rowLength + column) * wordsPerCell];
+			for (int32 neighbourIndex = 0; neighbourIndex < 4; neighbourIndex++)
+			{
+				if (neighbours[neighbourIndex] == INDEX_NONE)
+				{
+					continue;
+				}
+
+				const uint32 *neighbourBits = &original[(firstCell + neighbours[neighbourIndex]) * wordsPerCell];
+				for (int32 word = 0; word < wordsPerCell; word++)
+				{
+					cellBits[word] |= neighbourBits[word];
+				}
+			}
+		}
+	}
+}
+
+const FVisibilityTable::FTourCells *FVisibilityTable::findTour(const FString &tourName) const
+{
+	for (int32 tourIndex = 0; tourIndex < tours.Num(); tourIndex++)
+	{
+		if (tours[tourIndex].name == tourName)
+		{
+			return &tours[tourIndex];
+		}
+	}
+	return NULL;
+}
+
+int32 FVisibilityTable::findTourCell(const FString &tourName, float distance) const
+{
+	const FTourCells *tour = findTour(tourName);
+	if (tour == NULL)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 cellIndex = FMath::Clamp(FMath::FloorToInt(distance / tour->cellLength), 0, tour->numCells - 1);
+	return tour->firstCell + cellIndex;
+}
+
+int32 FVisibilityTable::findOrbitCell(float pitch, float yaw) const
+{
+	if (orbitFirstCell == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const float pitchRange = FMath::Max(orbitMaxPitch - orbitMinPitch, KINDA_SMALL_NUMBER);
+	const int32 pitchIndex = FMath::Clamp(FMath::FloorToInt((pitch - orbitMinPitch) / pitchRange * orbitPitchCells), 0, orbitPitchCells - 1);
+	const int32 yawIndex = FMath::Clamp(FMath::FloorToInt(FRotator::ClampAxis(yaw) / 360.0f * orbitYawCells), 0, orbitYawCells - 1);
+	return orbitFirstCell + pitchIndex * orbitYawCells + yawIndex;
+}
+
+float FVisibilityTable::getTourCellDistance(const FString &tourName, int32 cell) const
+{
+	const FTourCells *tour = findTour(tourName);
+	return tour != NULL ? (cell - tour->firstCell + 0.5f) * tour->cellLength : 0.0f;
+}
+
+void FVisibilityTable::getOrbitCellAngles(int32 cell, float &outPitch, float &outYaw) const
+{
+	const int32 orbitCell = cell - orbitFirstCell;
+	const int32 pitchIndex = orbitCell / orbitYawCells;
+	const int32 yawIndex = orbitCell % orbitYawCells;
+	outPitch = orbitMinPitch + (pitchIndex + 0.5f) * (orbitMaxPitch - orbitMinPitch) / orbitPitchCells;
+	outYaw = (yawIndex + 0.5f) * 360.0f / orbitYawCells;
+}
+
+bool FVisibilityTable::save(const FString &path) const
+{
+	TArray<uint8> data;
+	FMemoryWriter writer(data);
+	uint32 magic = VisibilityTableMagic;
+	uint32 version = VisibilityTableVersion;
+	writer << magic;
+	writer << version;
+	writer << const_cast<FVisibilityTable &>(*this);
+
+	if (!FFileHelper::SaveArrayToFile(data, *path))
+	{
+		UE_LOG(Kilograph, Error, TEXT("Failed to save visibility table to %s"), *path);
+		return false;
+	}
+	return true;
+}
+
+bool FVisibilityTable::load(const FString &path)
+{
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader reader(data);
+	uint32 magic = 0;
+	uint32 version = 0;
+	reader << magic;
+	reader << version;
+	if (magic != VisibilityTableMagic || version != VisibilityTableVersion)
+	{
+		UE_LOG(Kilograph, Error, TEXT("%s is not a supported visibility table"), *path);
+		return false;
+	}
+
+	reader << *this;
+	if (reader.IsError() || bits.Num() != numCells * wordsPerCell)
+	{
+		UE_LOG(Kilograph, Error, TEXT("Visibility table %s is corrupt"), *path);
+		reset(TArray<FString>());
+		return false;
+	}
+	return true;
+}
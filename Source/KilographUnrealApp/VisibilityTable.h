@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Precomputed visibility for the fixed camera paths of the app. The tour paths are split into
+ * cells by distance and the orbit shell into cells by angle, and every cell stores a bitset of
+ * the actors visible from it. Tables are baked offline by UVisibilityBakeCommandlet.
+ */
+class KILOGRAPHUNREALAPP_API FVisibilityTable
+{
+public:
+	FVisibilityTable();
+
+	// Start an empty table over the given actors, cells are added afterwards
+	void reset(const TArray<FString> &actorNamesInput);
+
+	// Add cells covering a tour path, returns the index of its first cell
+	int32 addTour(const FString &tourName, float pathLength, float cellLength);
+
+	// Add cells covering the orbit shell, returns the index of its first cell
+	int32 addOrbit(float minPitch, float maxPitch, int32 pitchCells, int32 yawCells);
+
+	// Mark an actor as visible from a cell
+	void setVisible(int32 cell, int32 actorIndex);
+
+	// Make every actor visible from a cell visible from the cells next to it as well. The cells form rows of
+	// rowLength that wrap around, a tour is a single row and the orbit a row of yaw cells per pitch
+	void dilateCells(int32 firstCell, int32 numRows, int32 rowLength);
+
+	// Whether an actor is visible from a cell
+	bool isVisible(int32 cell, int32 actorIndex) const
+	{
+		return (bits[cell * wordsPerCell + (actorIndex >> 5)] & (1u << (actorIndex & 31))) != 0;
+	}
+
+	// Cell of a tour at the given distance along its path, INDEX_NONE if the tour is not in the table
+	int32 findTourCell(const FString &tourName, float distance) const;
+
+	// Cell of the orbit shell at the given angles, INDEX_NONE if the table has no orbit
+	int32 findOrbitCell(float pitch, float yaw) const;
+
+	// Center distance of a tour cell, used when baking
+	float getTourCellDistance(const FString &tourName, int32 cell) const;
+
+	// Pitch and yaw at the center of an orbit cell, used when baking
+	void getOrbitCellAngles(int32 cell, float &outPitch, float &outYaw) const;
+
+	// Range of the orbit shell's cells, outNumCells is 0 if the table has no orbit
+	void getOrbitCells(int32 &outFirstCell, int32 &outNumCells) const
+	{
+		outFirstCell = orbitFirstCell;
+		outNumCells = orbitFirstCell != INDEX_NONE ? orbitPitchCells * orbitYawCells : 0;
+	}
+
+	// Actors covered by the table, by name
+	const TArray<FString> &getActorNames() const { return actorNames; }
+
+	// Number of cells in the table
+	int32 getNumCells() const { return numCells; }
+
+	// Write the table to disk
+	bool save(const FString &path) const;
+
+	// Read a table from disk
+	bool load(const FString &path);
+
+	friend FArchive &operator<<(FArchive &Ar, FVisibilityTable &table);
+
+private:
+	struct FTourCells
+	{
+		FString name;
+		float cellLength;
+		int32 firstCell;
+		int32 numCells;
+
+		friend FArchive &operator<<(FArchive &Ar, FTourCells &tour)
+		{
+			Ar << tour.name;
+			Ar << tour.cellLength;
+			Ar << tour.firstCell;
+			Ar << tour.numCells;
+			return Ar;
+		}
+	};
+
+	// Append empty cells, returns the index of the first one
+	int32 addCells(int32 count);
+
+	// Find the cells of a tour by name
+	const FTourCells *findTour(const FString &tourName) const;
+
+	TArray<FString> actorNames;
+	TArray<FTourCells> tours;
+
+	float orbitMinPitch;
+	float orbitMaxPitch;
+	int32 orbitPitchCells;
+	int32 orbitYawCells;
+	int32 orbitFirstCell;
+
+	int32 wordsPerCell;
+	int32 numCells;
+	TArray<uint32> bits;
+};
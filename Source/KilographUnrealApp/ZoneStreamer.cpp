@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealApp.h"
+#include "ZoneStreamer.h"
+#include "CameraFollow.h"
+#include "TourPrefetcher.h"
+#include "Engine/LevelStreaming.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Zone Streaming"), STAT_ZoneStreaming, STATGROUP_Kilograph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Requested Zones"), STAT_RequestedZones, STATGROUP_Kilograph);
+
+// Sets default values for this component's properties
+UZoneStreamer::UZoneStreamer()
+{
+	// Zones are the size of floors, a few updates a second follow the player closely enough
+	bWantsBeginPlay = true;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickInterval = 0.25f;
+
+	loadDistance = 1000.0f;
+	unloadDistance = 3000.0f;
+	minResidentTime = 10.0f;
+	waypointLookahead = 2;
+	maxConcurrentLoads = 1;
+	memoryCeilingMB = 0.0f;
+	tour = NULL;
+	prefetcher = NULL;
+}
+
+// Called when the game starts
+void UZoneStreamer::BeginPlay()
+{
+	Super::BeginPlay();
+
+	zoneStates.SetNum(zones.Num());
+	for (int32 zoneIndex = 0; zoneIndex < zones.Num(); zoneIndex++)
+	{
+		FZoneState &zoneState = zoneStates[zoneIndex];
+		AActor *boundsActor = zones[zoneIndex].boundsActor;
+		zoneState.bounds = boundsActor != NULL ? boundsActor->GetComponentsBoundingBox(true) : FBox(0);
+		zoneState.level = UGameplayStatics::GetStreamingLevel(this, zones[zoneIndex].levelName);
+		zoneState.requestTime = 0.0f;
+		zoneState.requestedUntil = 0.0f;
+
+		// Zones the map loads from the start are resident already, they are released like any other
+		zoneState.requested = zoneState.level.IsValid() && zoneState.level->bShouldBeLoaded;
+		if (zoneState.requested)
+		{
+			INC_DWORD_STAT(STAT_RequestedZones);
+		}
+
+		if (!zoneState.level.IsValid())
+		{
+			UE_LOG(Kilograph, Warning, TEXT("Zone %s is not a streaming level of this map"), *zones[zoneIndex].levelName.ToString());
+		}
+	}
+}
+
+void UZoneStreamer::startStreaming(UCameraFollow *tourInput)
+{
+	if (prefetcher != NULL)
+	{
+		prefetcher->setZoneStreamer(NULL);
+	}
+
+	// The tour's prefetcher looks further ahead, the zones it wants are loaded here rather than by it
+	tour = tourInput;
+	prefetcher = tour != NULL ? tour->GetOwner()->FindComponentByClass<UTourPrefetcher>() : NULL;
+	if (prefetcher != NULL)
+	{
+		prefetcher->setZoneStreamer(this);
+	}
+
+	SetComponentTickEnabled(true);
+}
+
+void UZoneStreamer::stopStreaming()
+{
+	if (prefetcher != NULL)
+	{
+		prefetcher->setZoneStreamer(NULL);
+	}
+	tour = NULL;
+	prefetcher = NULL;
+	SetComponentTickEnabled(false);
+}
+
+void UZoneStreamer::loadAllZones()
+{
+	stopStreaming();
+
+	// The orbit looks at the whole building, every zone is asked for at once
+	for (int32 zoneIndex = 0; zoneIndex < zoneStates.Num(); zoneIndex++)
+	{
+		setZoneLoaded(zoneIndex, true);
+	}
+}
+
+bool UZoneStreamer::requestZone(FName levelName)
+{
+	for (int32 zoneIndex = 0; zoneIndex < zones.Num(); zoneIndex++)
+	{
+		if (zones[zoneIndex].levelName == levelName && zoneStates.IsValidIndex(zoneIndex))
+		{
+			// Wanted until a couple of updates pass without the request being renewed
+			zoneStates[zoneIndex].requestedUntil = GetWorld()->GetTimeSeconds() + PrimaryComponentTick.TickInterval * 2.0f;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Called at the update interval while streaming
+void UZoneStreamer::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneStreaming);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	TArray<FVector> focusPoints;
+	gatherFocusPoints(focusPoints);
+
+	const float now = GetWorld()->GetTimeSeconds();
+	const bool overCeiling = memoryCeilingMB > 0.0f && FPlatformMemory::GetStats().UsedPhysical > (uint64)(memoryCeilingMB * 1024.0f * 1024.0f);
+	const float loadDistanceSquared = loadDistance * loadDistance;
+	const float unloadDistanceSquared = FMath::Max(unloadDistance, loadDistance) * FMath::Max(unloadDistance, loadDistance);
+
+	// Distance from every zone to the nearest focus point, and the loads still in flight
+	TArray<float> distancesSquared;
+	distancesSquared.Init(BIG_NUMBER, zoneStates.Num());
+	int32 loading = 0;
+	for (int32 zoneIndex = 0; zoneIndex < zoneStates.Num(); zoneIndex++)
+	{
+		const FZoneState &zoneState = zoneStates[zoneIndex];
+		if (!zoneState.bounds.IsValid)
+		{
+			continue;
+		}
+
+		for (int32 pointIndex = 0; pointIndex < focusPoints.Num(); pointIndex++)
+		{
+			distancesSquared[zoneIndex] = FMath::Min(distancesSquared[zoneIndex], zoneState.bounds.ComputeSquaredDistanceToPoint(focusPoints[pointIndex]));
+		}
+
+		ULevelStreaming *level = zoneState.level.Get();
+		if (zoneState.requested && level != NULL && level->GetLoadedLevel() == NULL)
+		{
+			loading++;
+		}
+	}
+
+	// Zones are only released well outside the load distance and once they have been resident a while
+	int32 furthestUnneeded = INDEX_NONE;
+	for (int32 zoneIndex = 0; zoneIndex < zoneStates.Num(); zoneIndex++)
+	{
+		const FZoneState &zoneState = zoneStates[zoneIndex];
+		if (!zoneState.requested || zoneState.requestedUntil > now || zoneState.bounds.IsInside(focusPoints[0]))
+		{
+			continue;
+		}
+
+		if (distancesSquared[zoneIndex] > unloadDistanceSquared && now - zoneState.requestTime >= minResidentTime)
+		{
+			setZoneLoaded(zoneIndex, false);
+		}
+		else if (distancesSquared[zoneIndex] > loadDistanceSquared &&
+			(furthestUnneeded == INDEX_NONE || distancesSquared[zoneIndex] > distancesSquared[furthestUnneeded]))
+		{
+			furthestUnneeded = zoneIndex;
+		}
+	}
+
+	// Over the ceiling the hysteresis gives way, one unneeded zone goes per update
+	if (overCeiling && furthestUnneeded != INDEX_NONE)
+	{
+		setZoneLoaded(furthestUnneeded, false);
+	}
+
+	// Load the wanted zones nearest first, a few at a time so the loads don't compete
+	TArray<int32> wantedZones;
+	for (int32 zoneIndex = 0; zoneIndex < zoneStates.Num(); zoneIndex++)
+	{
+		const FZoneState &zoneState = zoneStates[zoneIndex];
+		if (!zoneState.requested && (distancesSquared[zoneIndex] <= loadDistanceSquared || zoneState.requestedUntil > now))
+		{
+			wantedZones.Add(zoneIndex);
+		}
+	}
+	wantedZones.Sort([&distancesSquared](int32 first, int32 second) { return distancesSquared[first] < distancesSquared[second]; });
+
+	for (int32 wantedIndex = 0; wantedIndex < wantedZones.Num() && loading < maxConcurrentLoads; wantedIndex++)
+	{
+		const int32 zoneIndex = wantedZones[wantedIndex];
+		if (overCeiling && !zoneStates[zoneIndex].bounds.IsInside(focusPoints[0]))
+		{
+			continue;
+		}
+
+		setZoneLoaded(zoneIndex, true);
+		loading++;
+	}
+}
+
+void UZoneStreamer::gatherFocusPoints(TArray<FVector> &outPoints) const
+{
+	outPoints.Reset();
+	outPoints.Add(GetOwner()->GetActorLocation());
+
+	if (tour == NULL || !tour->getTourPath().isValid())
+	{
+		return;
+	}
+
+	// The next waypoints of the tour, wrapping around the loop
+	const FTourPath &path = tour->getTourPath();
+	const int32 numPoints = path.getNumControlPoints();
+	float alpha;
+	const int32 segment = path.findSegment(tour->getDistanceAlongPath(), alpha);
+	for (int32 ahead = 1; ahead <= FMath::Min(waypointLookahead, numPoints); ahead++)
+	{
+		outPoints.Add(path.getLocationAtDistance(path.getControlPointDistance((segment + ahead) % numPoints)));
+	}
+}
+
+void UZoneStreamer::setZoneLoaded(int32 zoneIndex, bool load)
+{
+	FZoneState &zoneState = zoneStates[zoneIndex];
+	ULevelStreaming *level = zoneState.level.Get();
+	if (level == NULL || zoneState.requested == load)
+	{
+		return;
+	}
+
+	level->bShouldBeLoaded = load;
+	level->bShouldBeVisible = load;
+	zoneState.requested = load;
+	if (load)
+	{
+		zoneState.requestTime = GetWorld()->GetTimeSeconds();
+		INC_DWORD_STAT(STAT_RequestedZones);
+	}
+	else
+	{
+		DEC_DWORD_STAT(STAT_RequestedZones);
+	}
+
+	UE_LOG(Kilograph, Verbose, TEXT("%s zone %s"), load ? TEXT("Loading") : TEXT("Unloading"), *zones[zoneIndex].levelName.ToString());
+}
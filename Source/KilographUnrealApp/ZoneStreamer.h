@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "ZoneStreamer.generated.h"
+
+class UCameraFollow;
+class UTourPrefetcher;
+
+/** A sublevel holding one floor or cell of the scene and the area it covers */
+USTRUCT()
+struct FStreamingZone
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Name of the streaming level */
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	FName levelName;
+
+	/** Actor whose bounds cover the zone, usually a volume around the floor */
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	AActor *boundsActor;
+
+	FStreamingZone() : boundsActor(NULL) {}
+};
+
+/**
+ * Keeps only the zones around the player resident while walking or touring. A zone is loaded
+ * when the owner or one of the next waypoints of the tour comes within loadDistance of it, and
+ * only unloaded once everything is further than unloadDistance and it has been resident for a
+ * while, so walking along a zone's edge doesn't thrash it. Loads are issued a few at a time,
+ * nearest first, and above the memory ceiling the furthest unneeded zone is dropped and only
+ * the zone the player stands in may still load. Ticks only while streaming. The orbit sees every
+ * zone, so entering it loads them all.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class KILOGRAPHUNREALAPP_API UZoneStreamer : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UZoneStreamer();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called at the update interval while streaming
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Stream around the owner, and along the tour when one is given
+	void startStreaming(UCameraFollow *tourInput);
+
+	// Stop streaming, the resident zones stay loaded
+	void stopStreaming();
+
+	// Stop streaming and load every zone, for views that see the whole scene
+	void loadAllZones();
+
+	// Ask for a zone to be resident over the next updates, returns false if the level is not a zone
+	bool requestZone(FName levelName);
+
+	// Distance from a zone's bounds within which it is loaded
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	float loadDistance;
+
+	// Distance from a zone's bounds beyond which it may be unloaded, larger than loadDistance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	float unloadDistance;
+
+	// Shortest time in seconds a zone stays resident once loaded
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	float minResidentTime;
+
+	// Tour waypoints ahead of the player whose zones are loaded in advance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	int32 waypointLookahead;
+
+	// Zones loading at once, more loads wait for these to finish
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	int32 maxConcurrentLoads;
+
+	// Used physical memory in MB above which unneeded zones are unloaded, 0 has no ceiling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming)
+	float memoryCeilingMB;
+
+	// Zones of the scene
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	TArray<FStreamingZone> zones;
+
+private:
+	struct FZoneState
+	{
+		FBox bounds;
+		TWeakObjectPtr<class ULevelStreaming> level;
+		bool requested;
+		// Game time the zone was asked to load, and until which a request keeps it wanted
+		float requestTime;
+		float requestedUntil;
+	};
+
+	// Points whose surroundings should be resident, the owner first
+	void gatherFocusPoints(TArray<FVector> &outPoints) const;
+
+	// Ask a zone's level to load and show or to unload
+	void setZoneLoaded(int32 zoneIndex, bool load);
+
+	// The tour whose waypoints are streamed ahead, NULL while walking
+	UCameraFollow *tour;
+
+	// Prefetcher of the tour, handing its levels to this component while streaming
+	UTourPrefetcher *prefetcher;
+
+	TArray<FZoneState> zoneStates;
+};
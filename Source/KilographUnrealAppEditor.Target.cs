@@ -21,5 +21,6 @@ public class KilographUnrealAppEditorTarget : TargetRules
 		)
 	{
 		OutExtraModuleNames.Add("KilographUnrealApp");
+		OutExtraModuleNames.Add("KilographUnrealAppTests");
 	}
 }
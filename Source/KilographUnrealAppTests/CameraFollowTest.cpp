@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealAppTests.h"
+#include "CameraFollow.h"
+#include "TourAsset.h"
+
+// A square tour with sides of 1000, optionally resting and slowing at its second corner
+static UTourAsset *makeSquareTour(float dwell, float speed)
+{
+	TArray<FTourControlPoint> controlPoints;
+	const FVector corners[] = { FVector(0.0f, 0.0f, 0.0f), FVector(1000.0f, 0.0f, 0.0f), FVector(1000.0f, 1000.0f, 0.0f), FVector(0.0f, 1000.0f, 0.0f) };
+	for (int32 cornerIndex = 0; cornerIndex < ARRAY_COUNT(corners); cornerIndex++)
+	{
+		FTourControlPoint point;
+		point.location = corners[cornerIndex];
+		controlPoints.Add(point);
+	}
+	controlPoints[1].dwell = dwell;
+	controlPoints[1].speed = speed;
+
+	UTourAsset *tour = NewObject<UTourAsset>();
+	tour->setControlPoints(controlPoints);
+	return tour;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCameraFollowAdvanceTest, "Kilograph.CameraFollow.Advance", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FCameraFollowAdvanceTest::RunTest(const FString &Parameters)
+{
+	// Without rests or speeds of its own the tour covers its speed times the time, and wraps at the end of the loop
+	UCameraFollow *follow = NewObject<UCameraFollow>();
+	follow->tours.Add(makeSquareTour(0.0f, 0.0f));
+	follow->bakePath();
+	const float length = follow->getTourPath().getLength();
+	TestTrue(TEXT("The tour has a length"), length > 0.0f);
+
+	follow->advance(1.0f);
+	TestTrue(TEXT("One second covers the tour speed"), FMath::IsNearlyEqual(follow->getDistanceAlongPath(), follow->tourSpeed, 1.0f));
+	TestEqual(TEXT("The first side is still being walked"), follow->getCurrentControlPoint(), 0);
+
+	const float lapTime = length / follow->tourSpeed;
+	for (int32 stepIndex = 0; stepIndex < 60; stepIndex++)
+	{
+		follow->advance(lapTime / 60.0f);
+	}
+	TestTrue(TEXT("A lap later the tour is back where it was"), FMath::IsNearlyEqual(follow->getDistanceAlongPath(), follow->tourSpeed, 2.0f));
+	TestTrue(TEXT("The tour stays within the loop"), follow->getDistanceAlongPath() >= 0.0f && follow->getDistanceAlongPath() < length);
+
+	// A rest at the second corner holds the tour there, then it carries on
+	follow = NewObject<UCameraFollow>();
+	follow->tours.Add(makeSquareTour(2.0f, 0.0f));
+	follow->bakePath();
+	const float cornerDistance = follow->getTourPath().getControlPointDistance(1);
+	follow->advance(cornerDistance / follow->tourSpeed + 1.0f);
+	TestTrue(TEXT("The tour rests at the corner"), FMath::IsNearlyEqual(follow->getDistanceAlongPath(), cornerDistance, 1.0f));
+	TestTrue(TEXT("The rest is partly over"), FMath::IsNearlyEqual(follow->getDwellRemaining(), 1.0f, 0.01f));
+	follow->advance(1.5f);
+	TestTrue(TEXT("The tour leaves the corner once the rest is over"), FMath::IsNearlyEqual(follow->getDistanceAlongPath(), cornerDistance + follow->tourSpeed * 0.5f, 5.0f));
+
+	// A corner's own speed is blended in along the sides next to it, so the faster corner is reached early
+	follow = NewObject<UCameraFollow>();
+	follow->tours.Add(makeSquareTour(0.0f, follow->tourSpeed * 2.0f));
+	follow->bakePath();
+	const float stepTime = cornerDistance / follow->tourSpeed * 0.9f / 100.0f;
+	for (int32 stepIndex = 0; stepIndex < 100; stepIndex++)
+	{
+		follow->advance(stepTime);
+	}
+	TestEqual(TEXT("The tour passes the faster corner early"), follow->getCurrentControlPoint(), 1);
+
+	return true;
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealAppTests.h"
+#include "TestWorld.h"
+#include "KinematicWalker.h"
+#include "Engine/StaticMeshActor.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFreeRunWalkTest, "Kilograph.FreeRun.Walk", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FFreeRunWalkTest::RunTest(const FString &Parameters)
+{
+	FTestWorld testWorld;
+	AKilographUnrealAppCharacter *character = testWorld.character;
+	if (!TestNotNull(TEXT("The character spawned"), character))
+	{
+		return false;
+	}
+
+	// A wide floor just below the character's feet for the walker to stand on
+	UStaticMesh *cube = LoadObject<UStaticMesh>(NULL, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("The floor mesh loaded"), cube))
+	{
+		return false;
+	}
+	AStaticMeshActor *floor = testWorld.world->SpawnActor<AStaticMeshActor>(FVector(0.0f, 0.0f, -150.0f), FRotator::ZeroRotator);
+	floor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+	floor->GetStaticMeshComponent()->SetStaticMesh(cube);
+	floor->SetActorScale3D(FVector(40.0f, 40.0f, 1.0f));
+
+	// Orbit first, then walk again the way the free run button does
+	UKinematicWalker *walker = character->GetKinematicWalker();
+	walker->enabled = true;
+	testWorld.enterOrbit();
+	TestFalse(TEXT("The walker stops while orbiting"), walker->isWalking());
+	character->activateFreeRun();
+	testWorld.finishTransition();
+	TestEqual(TEXT("Free run is entered"), character->getState(), AKilographUnrealAppCharacter::FREERUN);
+	TestTrue(TEXT("The walk picks up where the player last walked"), character->GetActorLocation().Equals(FVector::ZeroVector, 1.0f));
+	if (!TestTrue(TEXT("The walker takes over"), walker->isWalking()))
+	{
+		return false;
+	}
+
+	// A second of walking forward covers most of the walk speed
+	const FVector start = character->GetActorLocation();
+	for (int32 frameIndex = 0; frameIndex < 30; frameIndex++)
+	{
+		character->AddMovementInput(FVector(1.0f, 0.0f, 0.0f), 1.0f);
+		walker->TickComponent(1.0f / 30.0f, LEVELTICK_All, NULL);
+	}
+	const FVector moved = character->GetActorLocation() - start;
+	TestTrue(FString::Printf(TEXT("The walker moves the character forward, moved %s"), *moved.ToString()), moved.X > walker->walkSpeed * 0.5f);
+	TestTrue(TEXT("The walker keeps the character on the floor"), FMath::Abs(moved.Z) < 10.0f);
+
+	return true;
+}
@@ -0,0 +1,344 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealAppTests.h"
+#include "KiloBenchCommandlet.h"
+#include "TourPath.h"
+#include "BoundsHierarchy.h"
+#include "CameraFollow.h"
+#include "TourAsset.h"
+#include "TestWorld.h"
+#include "Json.h"
+
+// Sizes the tour and hotspot benchmarks are run at
+static const int32 BenchmarkSizes[] = { 10, 100, 1000, 10000 };
+
+// Queries timed per benchmark, enough to keep timer resolution out of the results
+static const int32 PathSamples = 100000;
+static const int32 OrbitUpdates = 1000000;
+static const int32 HotspotQueries = 10000;
+static const int32 TourSteps = 100000;
+static const int32 OrbitDrags = 100000;
+
+// Queries of each hotspot benchmark checked against a brute force search
+static const int32 HotspotChecks = 1000;
+
+UKiloBenchCommandlet::UKiloBenchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	failures = 0;
+}
+
+int32 UKiloBenchCommandlet::Main(const FString &Params)
+{
+	FString outPath = FPaths::GameSavedDir() / TEXT("Benchmarks") / TEXT("KiloBench.json");
+	FParse::Value(*Params, TEXT("Out="), outPath);
+	float tolerance = 0.2f;
+	FParse::Value(*Params, TEXT("Tolerance="), tolerance);
+
+	FString baselinePath = FPaths::GameDir() / TEXT("Source/KilographUnrealAppTests/Baseline/KiloBench.json");
+	FParse::Value(*Params, TEXT("Baseline="), baselinePath);
+
+	benchmarkTourPaths();
+	benchmarkTourAdvance();
+	benchmarkOrbit();
+	benchmarkOrbitDrag();
+	benchmarkHotspots();
+
+	if (!writeResults(outPath))
+	{
+		return 1;
+	}
+
+	const int32 regressions = compareBaseline(baselinePath, tolerance);
+	if (failures > 0)
+	{
+		UE_LOG(KilographTests, Error, TEXT("%d benchmarks disagreed with their reference"), failures);
+	}
+	return regressions > 0 || failures > 0 ? 1 : 0;
+}
+
+void UKiloBenchCommandlet::benchmarkTourPaths()
+{
+	FRandomStream random(1);
+	for (int32 sizeIndex = 0; sizeIndex < ARRAY_COUNT(BenchmarkSizes); sizeIndex++)
+	{
+		// Waypoints scattered around a loop, like a walk through a building
+		const int32 numWaypoints = BenchmarkSizes[sizeIndex];
+		TArray<FVector> waypoints;
+		for (int32 waypointIndex = 0; waypointIndex < numWaypoints; waypointIndex++)
+		{
+			const float angle = 2.0f * PI * waypointIndex / numWaypoints;
+			waypoints.Add(FVector(FMath::Cos(angle), FMath::Sin(angle), 0.0f) * 100.0f * numWaypoints + random.GetUnitVector() * 50.0f);
+		}
+
+		FTourPath path;
+		double start = FPlatformTime::Seconds();
+		path.build(waypoints);
+		addResult(FString::Printf(TEXT("tourPathBuildMs_%d"), numWaypoints), (FPlatformTime::Seconds() - start) * 1000.0);
+
+		// Step along the loop the way the tour does, a small advance per sample
+		const float step = path.getLength() / PathSamples * 7.0f;
+		float distance = 0.0f;
+		FVector checksum = FVector::ZeroVector;
+		start = FPlatformTime::Seconds();
+		for (int32 sampleIndex = 0; sampleIndex < PathSamples; sampleIndex++)
+		{
+			distance = path.wrapDistance(distance + step);
+			checksum += path.getLocationAtDistance(distance);
+		}
+		addResult(FString::Printf(TEXT("tourPathSampleNs_%d"), numWaypoints), (FPlatformTime::Seconds() - start) * 1e9 / PathSamples);
+		UE_LOG(KilographTests, Verbose, TEXT("Path checksum %s"), *checksum.ToString());
+	}
+}
+
+void UKiloBenchCommandlet::benchmarkTourAdvance()
+{
+	FRandomStream random(3);
+	for (int32 sizeIndex = 0; sizeIndex < ARRAY_COUNT(BenchmarkSizes); sizeIndex++)
+	{
+		// The same loops as the path benchmark, as a tour asset so the follower steps from control point to control point
+		const int32 numWaypoints = BenchmarkSizes[sizeIndex];
+		TArray<FTourControlPoint> controlPoints;
+		for (int32 waypointIndex = 0; waypointIndex < numWaypoints; waypointIndex++)
+		{
+			const float angle = 2.0f * PI * waypointIndex / numWaypoints;
+			FTourControlPoint point;
+			point.location = FVector(FMath::Cos(angle), FMath::Sin(angle), 0.0f) * 100.0f * numWaypoints + random.GetUnitVector() * 50.0f;
+			controlPoints.Add(point);
+		}
+
+		UTourAsset *tour = NewObject<UTourAsset>();
+		tour->setControlPoints(controlPoints);
+		UCameraFollow *follow = NewObject<UCameraFollow>();
+		follow->tours.Add(tour);
+		follow->bakePath();
+		const FTourPath &path = follow->getTourPath();
+
+		// Frame sized steps, like a tour running at 60 fps
+		const float stepTime = 1.0f / 60.0f;
+		const double start = FPlatformTime::Seconds();
+		for (int32 stepIndex = 0; stepIndex < TourSteps; stepIndex++)
+		{
+			follow->advance(stepTime);
+		}
+		addResult(FString::Printf(TEXT("tourAdvanceNs_%d"), numWaypoints), (FPlatformTime::Seconds() - start) * 1e9 / TourSteps);
+
+		// Without rests or speeds of its own the tour covers its speed times the time, around the loop
+		const double covered = (double)follow->tourSpeed * stepTime * TourSteps;
+		const double expected = FMath::Fmod(covered, (double)path.getLength());
+		const double error = FMath::Abs(follow->getDistanceAlongPath() - expected);
+		if (FMath::Min(error, path.getLength() - error) > covered * 0.001)
+		{
+			UE_LOG(KilographTests, Error, TEXT("%d waypoints: the tour ended %.1f along the loop, expected %.1f"), numWaypoints, follow->getDistanceAlongPath(), expected);
+			failures++;
+		}
+	}
+}
+
+void UKiloBenchCommandlet::benchmarkOrbit()
+{
+	// Without a probe radius the orbit camera never touches the world
+	UOrbitCamera *orbitCamera = NewObject<UOrbitCamera>();
+	orbitCamera->probeRadius = 0.0f;
+	orbitCamera->startOrbit(FVector::ZeroVector, 3000.0f);
+
+	FVector checksum = FVector::ZeroVector;
+	double start = FPlatformTime::Seconds();
+	for (int32 updateIndex = 0; updateIndex < OrbitUpdates; updateIndex++)
+	{
+		orbitCamera->setAngles((updateIndex % 90) - 45.0f, updateIndex * 0.37f);
+		checksum += orbitCamera->getCameraLocation();
+	}
+	const double orbitSeconds = FPlatformTime::Seconds() - start;
+	addResult(TEXT("orbitUpdateNs"), orbitSeconds * 1e9 / OrbitUpdates);
+
+	// The rotator, matrix and look at rotation each drag used to compute
+	start = FPlatformTime::Seconds();
+	for (int32 updateIndex = 0; updateIndex < OrbitUpdates; updateIndex++)
+	{
+		const FRotator rotation = FRotator::MakeFromEuler(FVector((updateIndex % 90) - 45.0f, 0.0f, updateIndex * 0.37f));
+		const FVector location = FRotationMatrix(rotation).TransformVector(FVector(0.0f, 3000.0f, 0.0f));
+		checksum += location + (-location).Rotation().Vector();
+	}
+	addResult(TEXT("orbitMatrixUpdateNs"), (FPlatformTime::Seconds() - start) * 1e9 / OrbitUpdates);
+
+	UE_LOG(KilographTests, Display, TEXT("Orbit camera: %.0f updates per second"), OrbitUpdates / FMath::Max(orbitSeconds, 1e-9));
+	UE_LOG(KilographTests, Verbose, TEXT("Orbit checksum %s"), *checksum.ToString());
+}
+
+void UKiloBenchCommandlet::benchmarkOrbitDrag()
+{
+	// The character only needs a world to be spawned in, the orbit never touches it without a probe radius
+	FTestWorld testWorld;
+	AKilographUnrealAppCharacter *character = testWorld.character;
+	if (character == NULL)
+	{
+		UE_LOG(KilographTests, Error, TEXT("Could not spawn a character to drag the orbit of"));
+		failures++;
+		return;
+	}
+
+	testWorld.enterOrbit();
+	character->orbitSmoothingTime = 0.0f;
+
+	// Drags large enough to keep running into the pitch limits
+	int32 outOfRange = 0;
+	double start = FPlatformTime::Seconds();
+	for (int32 dragIndex = 0; dragIndex < OrbitDrags; dragIndex++)
+	{
+		character->applyDrag((dragIndex % 7) - 3.0f, ((dragIndex % 13) - 6.0f) * 4.0f);
+		outOfRange += character->getOrbitPitch() < character->minRotationX || character->getOrbitPitch() > character->maxRotationX ? 1 : 0;
+	}
+	addResult(TEXT("orbitDragNs"), (FPlatformTime::Seconds() - start) * 1e9 / OrbitDrags);
+
+	start = FPlatformTime::Seconds();
+	for (int32 updateIndex = 0; updateIndex < OrbitDrags; updateIndex++)
+	{
+		character->setOrbitAngles((updateIndex % 90) - 45.0f, updateIndex * 0.37f);
+	}
+	addResult(TEXT("orbitRepositionNs"), (FPlatformTime::Seconds() - start) * 1e9 / OrbitDrags);
+
+	if (outOfRange > 0)
+	{
+		UE_LOG(KilographTests, Error, TEXT("%d of %d orbit drags left the pitch limits"), outOfRange, OrbitDrags);
+		failures++;
+	}
+}
+
+void UKiloBenchCommandlet::benchmarkHotspots()
+{
+	FRandomStream random(2);
+	for (int32 sizeIndex = 0; sizeIndex < ARRAY_COUNT(BenchmarkSizes); sizeIndex++)
+	{
+		// Hotspot sized boxes spread through a 100m cube
+		const int32 numHotspots = BenchmarkSizes[sizeIndex];
+		TArray<FBox> bounds;
+		for (int32 hotspotIndex = 0; hotspotIndex < numHotspots; hotspotIndex++)
+		{
+			const FVector center(random.FRandRange(-5000.0f, 5000.0f), random.FRandRange(-5000.0f, 5000.0f), random.FRandRange(-5000.0f, 5000.0f));
+			bounds.Add(FBox::BuildAABB(center, FVector(random.FRandRange(20.0f, 100.0f))));
+		}
+
+		FBoundsHierarchy hierarchy;
+		double start = FPlatformTime::Seconds();
+		hierarchy.build(bounds);
+		addResult(FString::Printf(TEXT("hotspotBuildMs_%d"), numHotspots), (FPlatformTime::Seconds() - start) * 1000.0);
+
+		// Rays from outside the cube aimed at points inside it, like taps on the scene
+		TArray<FVector> origins;
+		TArray<FVector> directions;
+		for (int32 queryIndex = 0; queryIndex < HotspotQueries; queryIndex++)
+		{
+			const FVector origin = random.GetUnitVector() * 10000.0f;
+			const FVector aim(random.FRandRange(-5000.0f, 5000.0f), random.FRandRange(-5000.0f, 5000.0f), random.FRandRange(-5000.0f, 5000.0f));
+			origins.Add(origin);
+			directions.Add((aim - origin).GetSafeNormal());
+		}
+
+		int32 hits = 0;
+		float distance;
+		start = FPlatformTime::Seconds();
+		for (int32 queryIndex = 0; queryIndex < HotspotQueries; queryIndex++)
+		{
+			hits += hierarchy.raycast(origins[queryIndex], directions[queryIndex], 20000.0f, distance) != INDEX_NONE ? 1 : 0;
+		}
+		addResult(FString::Printf(TEXT("hotspotRaycastNs_%d"), numHotspots), (FPlatformTime::Seconds() - start) * 1e9 / HotspotQueries);
+
+		// A fast but wrong hierarchy is no improvement
+		int32 mismatches = 0;
+		for (int32 queryIndex = 0; queryIndex < HotspotChecks; queryIndex++)
+		{
+			const FVector inverseDirection(1.0f / directions[queryIndex].X, 1.0f / directions[queryIndex].Y, 1.0f / directions[queryIndex].Z);
+			float closestDistance = 20000.0f;
+			int32 closest = INDEX_NONE;
+			for (int32 hotspotIndex = 0; hotspotIndex < numHotspots; hotspotIndex++)
+			{
+				const float hitDistance = FBoundsHierarchy::intersectBox(bounds[hotspotIndex], origins[queryIndex], inverseDirection, closestDistance);
+				if (hitDistance >= 0.0f && (closest == INDEX_NONE || hitDistance < closestDistance))
+				{
+					closest = hotspotIndex;
+					closestDistance = hitDistance;
+				}
+			}
+
+			mismatches += hierarchy.raycast(origins[queryIndex], directions[queryIndex], 20000.0f, distance) != closest ? 1 : 0;
+		}
+
+		UE_LOG(KilographTests, Display, TEXT("%d hotspots: %d of %d rays hit"), numHotspots, hits, HotspotQueries);
+		if (mismatches > 0)
+		{
+			UE_LOG(KilographTests, Error, TEXT("%d hotspots: %d of %d queries disagree with a brute force search"), numHotspots, mismatches, HotspotChecks);
+			failures++;
+		}
+	}
+}
+
+void UKiloBenchCommandlet::addResult(const FString &name, double value)
+{
+	resultNames.Add(name);
+	results.Add(name, value);
+	UE_LOG(KilographTests, Display, TEXT("%-28s %12.3f"), *name, value);
+}
+
+bool UKiloBenchCommandlet::writeResults(const FString &path) const
+{
+	FString output;
+	TSharedRef<TJsonWriter<> > writer = TJsonWriterFactory<>::Create(&output);
+
+	writer->WriteObjectStart();
+	writer->WriteObjectStart(TEXT("results"));
+	for (int32 resultIndex = 0; resultIndex < resultNames.Num(); resultIndex++)
+	{
+		writer->WriteValue(resultNames[resultIndex], results[resultNames[resultIndex]]);
+	}
+	writer->WriteObjectEnd();
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(output, *path))
+	{
+		UE_LOG(KilographTests, Error, TEXT("Failed to write benchmark results to %s"), *path);
+		return false;
+	}
+
+	UE_LOG(KilographTests, Display, TEXT("Wrote benchmark results to %s"), *path);
+	return true;
+}
+
+int32 UKiloBenchCommandlet::compareBaseline(const FString &path, float tolerance) const
+{
+	FString input;
+	TSharedPtr<FJsonObject> baseline;
+	if (!FFileHelper::LoadFileToString(input, *path) ||
+		!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(input), baseline) || !baseline.IsValid() ||
+		!baseline->HasTypedField<EJson::Object>(TEXT("results")))
+	{
+		UE_LOG(KilographTests, Error, TEXT("Could not read benchmark baseline %s"), *path);
+		return 1;
+	}
+
+	const TSharedPtr<FJsonObject> baselineResults = baseline->GetObjectField(TEXT("results"));
+	int32 regressions = 0;
+	for (int32 resultIndex = 0; resultIndex < resultNames.Num(); resultIndex++)
+	{
+		const FString &name = resultNames[resultIndex];
+		double baselineValue;
+		if (!baselineResults->TryGetNumberField(name, baselineValue))
+		{
+			continue;
+		}
+
+		const double value = results[name];
+		if (value > baselineValue * (1.0 + tolerance))
+		{
+			UE_LOG(KilographTests, Error, TEXT("%s regressed from %.3f to %.3f"), *name, baselineValue, value);
+			regressions++;
+		}
+	}
+
+	UE_LOG(KilographTests, Display, TEXT("%d regressions against baseline %s"), regressions, *path);
+	return regressions;
+}
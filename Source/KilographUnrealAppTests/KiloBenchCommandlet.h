@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "KiloBenchCommandlet.generated.h"
+
+/**
+ * Micro-benchmarks of the app's hot paths: baking, sampling and advancing tour paths of 10 to 10k
+ * waypoints, orbit camera updates, orbit drags and repositions of the character, and hotspot ray
+ * queries against 10 to 10k hotspots. Every result is a cost where lower is better, written as
+ * JSON and compared against a stored baseline, the run fails if any result regressed beyond the
+ * tolerance or any benchmark's output disagrees with a reference computation. Needs no map or
+ * renderer. Lives with the tests so it never ships, the baseline defaults to the one kept here.
+ *
+ * Usage: UE4Editor-Cmd <Project> -run=KiloBench -nullrhi -unattended
+ *		[-Out=<file>] [-Baseline=<file>] [-Tolerance=0.2]
+ */
+UCLASS()
+class KILOGRAPHUNREALAPPTESTS_API UKiloBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UKiloBenchCommandlet();
+
+	// Run every benchmark and report the results
+	virtual int32 Main(const FString &Params) override;
+
+private:
+	// Bake and sample tour paths of increasing size
+	void benchmarkTourPaths();
+
+	// Advance a camera follow along tours of increasing size, checking it against the path length it covers
+	void benchmarkTourAdvance();
+
+	// Update an orbit camera, and the rotator and matrix path it replaced for reference
+	void benchmarkOrbit();
+
+	// Drag and reposition the orbit of a character, checking the drag stays within the pitch limits
+	void benchmarkOrbitDrag();
+
+	// Query hotspot hierarchies of increasing size, checking their hits against a brute force search
+	void benchmarkHotspots();
+
+	// Record a result under a name, lower is better
+	void addResult(const FString &name, double value);
+
+	// Write the results to a JSON file
+	bool writeResults(const FString &path) const;
+
+	// Compare the results against a baseline file, returns the number of regressions
+	int32 compareBaseline(const FString &path, float tolerance) const;
+
+	// Benchmarks whose output disagreed with the reference, any fails the run
+	int32 failures;
+
+	// Results in the order they were measured
+	TArray<FString> resultNames;
+	TMap<FString, double> results;
+};
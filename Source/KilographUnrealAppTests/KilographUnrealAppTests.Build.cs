@@ -0,0 +1,11 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class KilographUnrealAppTests : ModuleRules
+{
+	public KilographUnrealAppTests(TargetInfo Target)
+	{
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "Json", "KilographUnrealApp" });
+	}
+}
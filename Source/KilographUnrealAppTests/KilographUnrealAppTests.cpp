@@ -0,0 +1,9 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "KilographUnrealAppTests.h"
+
+
+IMPLEMENT_MODULE( FDefaultModuleImpl, KilographUnrealAppTests );
+
+// Test and benchmark log
+DEFINE_LOG_CATEGORY(KilographTests);
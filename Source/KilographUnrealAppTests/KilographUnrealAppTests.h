@@ -0,0 +1,14 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#ifndef __KILOGRAPHUNREALAPPTESTS_H__
+#define __KILOGRAPHUNREALAPPTESTS_H__
+
+#include "EngineMinimal.h"
+#include "AutomationTest.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(KilographTests, Log, All);
+
+// Automation tests of the game module, run headless with
+//	UE4Editor-Cmd <Project> -ExecCmds="Automation RunTests Kilograph; Quit" -unattended -nullrhi
+
+#endif
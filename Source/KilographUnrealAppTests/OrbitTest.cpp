@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealAppTests.h"
+#include "TestWorld.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOrbitDragClampTest, "Kilograph.Orbit.DragClamp", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FOrbitDragClampTest::RunTest(const FString &Parameters)
+{
+	FTestWorld testWorld;
+	AKilographUnrealAppCharacter *character = testWorld.character;
+	if (!TestNotNull(TEXT("The character spawned"), character))
+	{
+		return false;
+	}
+	testWorld.enterOrbit();
+	TestEqual(TEXT("The overview enters the orbit"), character->getState(), AKilographUnrealAppCharacter::ORBIT);
+	character->orbitSmoothingTime = 0.0f;
+
+	// Dragging up or down stops at the pitch limits
+	character->applyDrag(0.0f, -1000.0f);
+	TestEqual(TEXT("Dragging down stops at the highest pitch"), character->getOrbitPitch(), character->maxRotationX);
+	character->applyDrag(0.0f, 1000.0f);
+	TestEqual(TEXT("Dragging up stops at the lowest pitch"), character->getOrbitPitch(), character->minRotationX);
+	character->applyDrag(0.0f, -10.0f);
+	TestEqual(TEXT("A drag within the limits moves the pitch by the drag"), character->getOrbitPitch(), character->minRotationX + 10.0f);
+
+	// Dragging sideways turns around the target without limit
+	const float startZ = character->getOrbitYaw();
+	character->applyDrag(1000.0f, 0.0f);
+	TestEqual(TEXT("Dragging sideways isn't clamped"), character->getOrbitYaw(), startZ + 1000.0f);
+	TestEqual(TEXT("Dragging sideways leaves the pitch"), character->getOrbitPitch(), character->minRotationX + 10.0f);
+
+	// With smoothing only the target moves, Tick eases the orbit towards it
+	character->orbitSmoothingTime = 0.2f;
+	character->applyDrag(0.0f, -1000.0f);
+	TestEqual(TEXT("The target pitch is clamped while smoothing"), character->getTargetOrbitPitch(), character->maxRotationX);
+	TestEqual(TEXT("The orbit waits for Tick while smoothing"), character->getOrbitPitch(), character->minRotationX + 10.0f);
+
+	// Outside the orbit the drags turn the view instead
+	character->activateSkyboxView();
+	testWorld.finishTransition();
+	TestEqual(TEXT("The skybox view leaves the orbit"), character->getState(), AKilographUnrealAppCharacter::PANORAMA);
+	const float targetX = character->getTargetOrbitPitch();
+	character->applyDrag(0.0f, 50.0f);
+	TestEqual(TEXT("Drags outside the orbit leave it alone"), character->getTargetOrbitPitch(), targetX);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOrbitRepositionTest, "Kilograph.Orbit.Reposition", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FOrbitRepositionTest::RunTest(const FString &Parameters)
+{
+	FTestWorld testWorld;
+	AKilographUnrealAppCharacter *character = testWorld.character;
+	if (!TestNotNull(TEXT("The character spawned"), character))
+	{
+		return false;
+	}
+	testWorld.enterOrbit();
+
+	const float angles[][2] = { { 0.0f, 0.0f }, { 30.0f, 45.0f }, { -20.0f, 200.0f }, { 60.0f, -90.0f } };
+	for (int32 angleIndex = 0; angleIndex < ARRAY_COUNT(angles); angleIndex++)
+	{
+		character->setOrbitAngles(angles[angleIndex][0], angles[angleIndex][1]);
+
+		// The view sits at the orbit offset from the target and looks back at it
+		const UOrbitCamera *orbitCamera = character->GetOrbitCamera();
+		const FVector expected = AKilographUnrealAppCharacter::computeOrbitOffset(angles[angleIndex][0], angles[angleIndex][1], character->rotationDistance);
+		TestTrue(FString::Printf(TEXT("The view is placed on the orbit at %.0f, %.0f"), angles[angleIndex][0], angles[angleIndex][1]),
+			orbitCamera->getCameraLocation().Equals(expected, 0.1f));
+		TestTrue(FString::Printf(TEXT("The view faces the target at %.0f, %.0f"), angles[angleIndex][0], angles[angleIndex][1]),
+			orbitCamera->getCameraRotation().Vector().Equals(-expected.GetSafeNormal(), 0.001f));
+	}
+
+	return true;
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "KilographUnrealAppCharacter.h"
+#include "ModeTransition.h"
+#include "OrbitCamera.h"
+
+// A transient world holding one character that orbits the origin, destroyed with the helper
+struct FTestWorld
+{
+	FTestWorld()
+	{
+		world = UWorld::CreateWorld(EWorldType::Game, false);
+		world->InitializeActorsForPlay(FURL());
+		character = world->SpawnActor<AKilographUnrealAppCharacter>();
+		if (character != NULL)
+		{
+			// Without a probe radius the orbit never traces, so the empty world doesn't matter
+			character->GetOrbitCamera()->probeRadius = 0.0f;
+			character->rotationDistance = 1000.0f;
+			character->rotationObject = world->SpawnActor<AActor>();
+			character->skyboxCenter = world->SpawnActor<AActor>();
+			// States take over on the next transition tick instead of blending
+			character->GetModeTransition()->blendTime = 0.0f;
+		}
+	}
+
+	~FTestWorld()
+	{
+		world->DestroyWorld(false);
+	}
+
+	// Let the transition the character started commit its new state
+	void finishTransition()
+	{
+		character->GetModeTransition()->TickComponent(0.0f, LEVELTICK_All, NULL);
+	}
+
+	// Switch to the orbit the way the overview button does
+	void enterOrbit()
+	{
+		character->activateOverviewMode();
+		finishTransition();
+	}
+
+	UWorld *world;
+	AKilographUnrealAppCharacter *character;
+};
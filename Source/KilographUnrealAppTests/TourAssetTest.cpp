@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "KilographUnrealAppTests.h"
+#include "TourAsset.h"
+#include "TourImportCommandlet.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTourAssetRoundTripTest, "Kilograph.TourAsset.RoundTrip", EAutomationTestFlags::ATF_Editor | EAutomationTestFlags::ATF_Game)
+
+bool FTourAssetRoundTripTest::RunTest(const FString &Parameters)
+{
+	// Path elements tagged the way the importer reads them, the second looking at a third actor
+	UWorld *world = UWorld::CreateWorld(EWorldType::Game, false);
+	AActor *target = world->SpawnActor<AActor>();
+	USceneComponent *targetRoot = NewObject<USceneComponent>(target);
+	target->SetRootComponent(targetRoot);
+	targetRoot->RegisterComponent();
+	target->SetActorLocation(FVector(500.0f, 500.0f, 100.0f));
+
+	TArray<AActor *> pathElements;
+	const FVector locations[] = { FVector(0.0f, 0.0f, 0.0f), FVector(1000.0f, 0.0f, 0.0f), FVector(1000.0f, 1000.0f, 0.0f) };
+	for (int32 elementIndex = 0; elementIndex < ARRAY_COUNT(locations); elementIndex++)
+	{
+		AActor *element = world->SpawnActor<AActor>();
+		USceneComponent *root = NewObject<USceneComponent>(element);
+		element->SetRootComponent(root);
+		root->RegisterComponent();
+		element->SetActorLocation(locations[elementIndex]);
+		pathElements.Add(element);
+	}
+	pathElements[1]->Tags.Add(TEXT("TourSpeed=300"));
+	pathElements[1]->Tags.Add(TEXT("TourDwell=2"));
+	pathElements[1]->Tags.Add(*FString::Printf(TEXT("TourLookAt=%s"), *target->GetName()));
+
+	TArray<FTourControlPoint> controlPoints;
+	UTourImportCommandlet::buildControlPoints(pathElements, controlPoints);
+	world->DestroyWorld(false);
+
+	if (!TestEqual(TEXT("Every path element becomes a control point"), controlPoints.Num(), ARRAY_COUNT(locations)))
+	{
+		return false;
+	}
+	TestEqual(TEXT("The speed tag is read"), controlPoints[1].speed, 300.0f);
+	TestEqual(TEXT("The dwell tag is read"), controlPoints[1].dwell, 2.0f);
+	TestTrue(TEXT("The look at tag is resolved to the actor's location"), controlPoints[1].hasLookAt != 0 && controlPoints[1].lookAt.Equals(FVector(500.0f, 500.0f, 100.0f)));
+	TestTrue(TEXT("Untagged elements don't look at anything"), controlPoints[0].hasLookAt == 0 && controlPoints[2].hasLookAt == 0);
+
+	// Saved and loaded again the points come back as they were
+	UTourAsset *tour = NewObject<UTourAsset>();
+	tour->setControlPoints(controlPoints);
+	TArray<uint8> bytes;
+	FMemoryWriter writer(bytes);
+	tour->Serialize(writer);
+
+	// The versions a package would have stored in its summary
+	UTourAsset *loaded = NewObject<UTourAsset>();
+	FMemoryReader reader(bytes);
+	reader.SetCustomVersions(writer.GetCustomVersions());
+	loaded->Serialize(reader);
+
+	const TArray<FTourControlPoint> &loadedPoints = loaded->getControlPoints();
+	if (!TestEqual(TEXT("Every point is loaded"), loadedPoints.Num(), controlPoints.Num()))
+	{
+		return false;
+	}
+	for (int32 pointIndex = 0; pointIndex < controlPoints.Num(); pointIndex++)
+	{
+		const FTourControlPoint &saved = controlPoints[pointIndex];
+		const FTourControlPoint &point = loadedPoints[pointIndex];
+		TestTrue(FString::Printf(TEXT("Point %d is loaded as saved"), pointIndex),
+			point.location == saved.location && point.speed == saved.speed && point.dwell == saved.dwell &&
+			point.lookAt == saved.lookAt && point.hasLookAt == saved.hasLookAt);
+	}
+
+	return true;
+}